@@ -0,0 +1,469 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef TIMPI_BENCH_H
+#define TIMPI_BENCH_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/parallel_implementation.h"
+#include "timpi/timpi_version.h"
+
+// C++ includes
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+// Shared harness for the TIMPI microbenchmarks: command line
+// options, calibrated timing loops, and JSON output.
+namespace TIMPIBench
+{
+
+using TIMPI::Communicator;
+
+/**
+ * Benchmark settings, from the command line:
+ *
+ * --sizes=1,64,4096    payload sizes to sweep, in elements
+ * --min-time=0.2       seconds to time each benchmark for, at least
+ * --max-iterations=N   stop timing a benchmark after N iterations
+ * --filter=a,b,...     only run benchmarks whose names contain one of these
+ * --output=file.json   write results here rather than to stdout
+ * --baseline=file.json compare against results from an earlier run
+ * --tolerance=0.25     fail on any slowdown past this fraction of baseline
+ * --help               print this usage summary and exit
+ */
+struct Options
+{
+  std::vector<std::size_t> sizes {1, 16, 256, 4096, 65536};
+  double min_time = 0.2;
+  unsigned long max_iterations = 1000000;
+  std::vector<std::string> filter;
+  std::string output;
+  std::string baseline;
+  double tolerance = 0.25;
+
+  // Set by --help, or by an unrecognized option; either way main()
+  // should print usage() and return
+  bool help = false;
+  std::string bad_option;
+};
+
+
+
+inline
+Options parse_options(int argc, const char * const * argv)
+{
+  Options options;
+
+  for (int i = 1; i < argc; ++i)
+    {
+      const std::string arg(argv[i]);
+      const std::size_t eq = arg.find('=');
+      const std::string key = arg.substr(0, eq),
+        value = (eq == std::string::npos) ? "" : arg.substr(eq+1);
+
+      if (key == "--sizes")
+        {
+          options.sizes.clear();
+          std::istringstream values(value);
+          std::string size;
+          while (std::getline(values, size, ','))
+            options.sizes.push_back(std::stoul(size));
+        }
+      else if (key == "--min-time")
+        options.min_time = std::stod(value);
+      else if (key == "--max-iterations")
+        options.max_iterations = std::stoul(value);
+      else if (key == "--filter")
+        {
+          std::istringstream values(value);
+          std::string name;
+          while (std::getline(values, name, ','))
+            options.filter.push_back(name);
+        }
+      else if (key == "--output")
+        options.output = value;
+      else if (key == "--baseline")
+        options.baseline = value;
+      else if (key == "--tolerance")
+        options.tolerance = std::stod(value);
+      else if (key == "--help")
+        options.help = true;
+      else
+        {
+          options.bad_option = arg;
+          options.help = true;
+        }
+    }
+
+  return options;
+}
+
+
+
+/**
+ * Prints the usage summary, after complaining about any unrecognized
+ * option, on rank 0 of \p comm (or on the only process, if \p comm is
+ * null), and returns the exit status for main().  Returning, rather
+ * than exiting, leaves any TIMPIInit to finalize MPI.
+ */
+inline
+int usage(const Options & options,
+          const Communicator * comm,
+          const char * program)
+{
+  const bool bad = !options.bad_option.empty();
+
+  if (!comm || comm->rank() == 0)
+    {
+      std::ostream & os = bad ? std::cerr : std::cout;
+      if (bad)
+        os << "Unrecognized option " << options.bad_option << '\n';
+      os << "Usage: " << program
+         << " [--sizes=n1,n2,...] [--min-time=seconds]"
+         << " [--max-iterations=n] [--filter=a,b,...]"
+         << " [--output=file.json] [--baseline=file.json]"
+         << " [--tolerance=fraction]" << std::endl;
+    }
+
+  return bad ? 1 : 0;
+}
+
+
+
+/**
+ * The timing of one benchmark configuration.  Times are seconds per
+ * iteration, and bytes are the payload bytes per iteration on each
+ * processor, or in total for single-process benchmarks.
+ */
+struct Result
+{
+  std::string name;
+  std::vector<std::pair<std::string, std::string>> parameters;
+  unsigned long iterations;
+  double min_seconds, avg_seconds, max_seconds;
+  double bytes;
+  double objects;
+};
+
+
+
+/**
+ * Runs benchmarks and collects their results.  With a Communicator,
+ * every benchmark is collective: each timing loop starts with a
+ * barrier, and the per-iteration time is reduced over processors.
+ */
+class Harness
+{
+public:
+  typedef std::vector<std::pair<std::string, std::string>> parameters_type;
+
+  Harness(const Communicator * comm,
+          const std::string & suite,
+          const Options & options) :
+    _comm(comm), _suite(suite), _options(options) {}
+
+  const Options & options() const { return _options; }
+
+  bool selected(const std::string & name) const
+  {
+    if (_options.filter.empty())
+      return true;
+    for (const std::string & f : _options.filter)
+      if (name.find(f) != std::string::npos)
+        return true;
+    return false;
+  }
+
+  /**
+   * Times \p f, which moves \p bytes bytes and \p objects objects per
+   * call, calling it as many times as it takes to fill the minimum
+   * time.
+   */
+  template <typename Functor>
+  void run(const std::string & name,
+           const parameters_type & parameters,
+           double bytes,
+           double objects,
+           Functor f);
+
+  /**
+   * Writes every result so far as JSON, on processor 0 only.
+   */
+  void write_json() const;
+
+  /**
+   * Compares every result so far against the baseline file, if one
+   * was given, and reports any benchmark slower than the baseline by
+   * more than the tolerance.  Returns false if there were any such
+   * slowdowns.  Collective.
+   */
+  bool check_baseline() const;
+
+private:
+  double max_over_processors(double t) const
+  {
+    if (_comm)
+      _comm->max(t);
+    return t;
+  }
+
+  const Communicator * const _comm;
+  const std::string _suite;
+  const Options _options;
+  std::vector<Result> _results;
+};
+
+
+
+template <typename Functor>
+inline
+void Harness::run(const std::string & name,
+                  const parameters_type & parameters,
+                  double bytes,
+                  double objects,
+                  Functor f)
+{
+  if (!this->selected(name))
+    return;
+
+  typedef std::chrono::steady_clock clock_type;
+
+  // Warm up caches, and any lazily created MPI state
+  f();
+
+  unsigned long iterations = 1;
+  double local_elapsed = 0, elapsed = 0;
+  while (true)
+    {
+      if (_comm)
+        _comm->barrier();
+
+      const clock_type::time_point start = clock_type::now();
+      for (unsigned long i = 0; i != iterations; ++i)
+        f();
+      local_elapsed =
+        std::chrono::duration<double>(clock_type::now() - start).count();
+      elapsed = max_over_processors(local_elapsed);
+
+      if (elapsed >= _options.min_time ||
+          iterations >= _options.max_iterations)
+        break;
+
+      // Aim a bit past the minimum time, but don't grow too fast if
+      // the first timings are noise
+      const double target = 1.2 * _options.min_time /
+        std::max(elapsed, 1e-9) * iterations;
+      iterations = std::min(_options.max_iterations,
+                            std::min(10 * iterations,
+                                     std::max(iterations + 1,
+                                              (unsigned long)(target))));
+    }
+
+  // The slowest processor determines throughput, but we report the
+  // spread too, since imbalance is worth knowing about.
+  double min = local_elapsed, sum = local_elapsed;
+  if (_comm)
+    {
+      _comm->min(min);
+      _comm->sum(sum);
+      sum /= _comm->size();
+    }
+
+  Result result {name, parameters, iterations,
+                 min / iterations, sum / iterations, elapsed / iterations,
+                 bytes, objects};
+
+  _results.push_back(std::move(result));
+}
+
+
+
+inline
+void print_json_string(std::ostream & os, const std::string & str)
+{
+  os << '"';
+  for (const char c : str)
+    {
+      if (c == '"' || c == '\\')
+        os << '\\';
+      os << c;
+    }
+  os << '"';
+}
+
+
+
+// The start of a result's JSON object, which identifies it for
+// comparisons against a baseline
+inline
+std::string json_key(const Result & r)
+{
+  std::ostringstream os;
+  os << "{\"name\": ";
+  print_json_string(os, r.name);
+  os << ", \"parameters\": {";
+  bool first_param = true;
+  for (const auto & p : r.parameters)
+    {
+      if (!first_param)
+        os << ", ";
+      first_param = false;
+      print_json_string(os, p.first);
+      os << ": ";
+      print_json_string(os, p.second);
+    }
+  os << '}';
+  return os.str();
+}
+
+
+
+inline
+void Harness::write_json() const
+{
+  if (_comm && _comm->rank() != 0)
+    return;
+
+  std::ofstream file;
+  if (!_options.output.empty())
+    file.open(_options.output);
+  std::ostream & os = _options.output.empty() ? std::cout : file;
+
+  os << "{\n  \"suite\": ";
+  print_json_string(os, _suite);
+  os << ",\n  \"timpi_version\": ";
+  print_json_string(os, TIMPI_LIB_VERSION);
+  os << ",\n  \"n_processors\": " << (_comm ? _comm->size() : 1)
+     << ",\n  \"min_time\": " << _options.min_time
+     << ",\n  \"results\": [";
+
+  bool first = true;
+  for (const Result & r : _results)
+    {
+      if (!first)
+        os << ',';
+      first = false;
+
+      os << "\n    " << json_key(r)
+         << std::scientific << std::setprecision(6)
+         << ", \"iterations\": " << r.iterations
+         << ", \"seconds\": {\"min\": " << r.min_seconds
+         << ", \"avg\": " << r.avg_seconds
+         << ", \"max\": " << r.max_seconds << '}'
+         << ", \"bytes\": " << r.bytes
+         << ", \"objects\": " << r.objects
+         << ", \"bytes_per_second\": " << r.bytes / r.max_seconds
+         << ", \"objects_per_second\": " << r.objects / r.max_seconds
+         << '}' << std::defaultfloat;
+    }
+
+  os << "\n  ]\n}\n";
+  os.flush();
+}
+
+
+
+inline
+bool Harness::check_baseline() const
+{
+  if (_options.baseline.empty())
+    return true;
+
+  // Only rank 0 reads the baseline; on failure it still returns
+  // normally, so every rank gets through the broadcast below
+  bool ok = true;
+  std::ifstream file;
+  if (!_comm || _comm->rank() == 0)
+    {
+      file.open(_options.baseline);
+      if (!file)
+        {
+          std::cerr << "Cannot read baseline " << _options.baseline
+                    << std::endl;
+          ok = false;
+        }
+    }
+
+  if (file.is_open())
+    {
+      std::stringstream contents;
+      contents << file.rdbuf();
+      const std::string baseline = contents.str();
+
+      std::ostream & os = _options.output.empty() ? std::cerr : std::cout;
+
+      const unsigned int n_procs = _comm ? _comm->size() : 1;
+      std::smatch match;
+      if (std::regex_search(baseline, match,
+                            std::regex("\"n_processors\": ([0-9]+)")) &&
+          std::stoul(match[1]) != n_procs)
+        os << "Warning: baseline was run on " << match[1]
+           << " processors, not " << n_procs << std::endl;
+
+      // Map each baseline result to its slowest per-iteration time
+      std::map<std::string, double> baseline_seconds;
+      const std::regex result_regex
+        ("(\\{\"name\": \".*?\", \"parameters\": \\{.*?\\}), "
+         "\"iterations\": [0-9]+, \"seconds\": \\{[^}]*\"max\": ([^}]*)\\}");
+      for (std::sregex_iterator it(baseline.begin(), baseline.end(),
+                                   result_regex), end;
+           it != end; ++it)
+        baseline_seconds[(*it)[1]] = std::stod((*it)[2]);
+
+      for (const Result & r : _results)
+        {
+          const std::string key = json_key(r);
+          const auto base_it = baseline_seconds.find(key);
+          if (base_it == baseline_seconds.end())
+            {
+              os << "No baseline for " << key << "}" << std::endl;
+              continue;
+            }
+
+          const double ratio = r.max_seconds / base_it->second;
+          const bool slower = ratio > 1 + _options.tolerance;
+          if (slower)
+            ok = false;
+
+          os << (slower ? "SLOWER " : "ok     ")
+             << std::fixed << std::setprecision(2) << ratio << "x "
+             << key << '}' << std::defaultfloat << std::endl;
+        }
+    }
+
+  if (_comm)
+    _comm->broadcast(ok);
+
+  return ok;
+}
+
+} // namespace TIMPIBench
+
+#endif // TIMPI_BENCH_H
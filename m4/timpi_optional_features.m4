@@ -92,6 +92,23 @@ AS_IF([test "$enablewarnings" != yes],
 # --------------------------------------------------------------
 
 
+# --------------------------------------------------------------
+# communication profiling - disabled by default
+# --------------------------------------------------------------
+AC_ARG_ENABLE(profiling,
+              AS_HELP_STRING([--enable-profiling],
+                             [compile in the TIMPI_LOG_SCOPE communication profiler]),
+              enableprofiling=$enableval,
+              enableprofiling=no)
+
+AS_IF([test "$enableprofiling" != no],
+      [
+        AC_DEFINE(ENABLE_PROFILING, 1, [Flag indicating if the library should be built with its communication profiler])
+        AC_MSG_RESULT(<<< Configuring library with communication profiling >>>)
+      ])
+# --------------------------------------------------------------
+
+
 # -------------------------------------------------------------
 # size of processor_id_type -- default 4 bytes
 # -------------------------------------------------------------
@@ -0,0 +1,481 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef TIMPI_ACTIVE_MESSAGES_H
+#define TIMPI_ACTIVE_MESSAGES_H
+
+// Local Includes
+#include "timpi/parallel_implementation.h"
+#include "timpi/termination_detector.h"
+
+// C++ includes
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>    // inserter
+#include <list>
+#include <type_traits> // integral_constant, is_base_of
+#include <utility>     // move, pair
+#include <vector>
+
+
+namespace TIMPI {
+
+//------------------------------------------------------------------------
+/**
+ * Asynchronous "call handler \p h on processor \p p with payload \p
+ * x" messaging on top of a Communicator.
+ *
+ * Handlers are registered with add_handler(), which returns an id
+ * for each; handlers must be added in the same order on every
+ * processor, so that ids agree.
+ *
+ * Messages sent with send() are buffered per destination, and a
+ * destination's buffer is sent as a single MPI message once it holds
+ * flush_size() messages or once its oldest message has waited for
+ * flush_delay(), whichever comes first.  Payloads are sent directly
+ * if \p Payload has a StandardType, or serialized via Packing<Payload>
+ * otherwise.
+ *
+ * Handlers are run, on the receiving processor, from within poll()
+ * and quiesce() as messages arrive; handlers may themselves send()
+ * more messages.  Messages to the local processor are queued and
+ * handled the same way, without any network operations.
+ *
+ * quiesce() is collective, and returns only once every message sent
+ * on any processor has been handled, and no handler is left to send
+ * more, as determined by a TerminationDetector.
+ *
+ * Construction is collective, since each ActiveMessages object uses
+ * its own unique MessageTag.
+ */
+template <typename Payload>
+class ActiveMessages
+{
+public:
+  typedef std::function<void(processor_id_type, Payload &&)> handler_type;
+
+  ActiveMessages(const Communicator & comm);
+
+  ~ActiveMessages();
+
+  ActiveMessages(const ActiveMessages &) = delete;
+  ActiveMessages & operator=(const ActiveMessages &) = delete;
+
+  /**
+   * Register a handler, returning the id with which to send() to it.
+   */
+  unsigned int add_handler(handler_type handler);
+
+  /**
+   * Queue up a call of handler \p handler_id with \p payload on
+   * processor \p dest_processor_id.
+   */
+  void send(processor_id_type dest_processor_id,
+            unsigned int handler_id,
+            Payload payload);
+
+  /**
+   * Send any buffered messages now, regardless of flush thresholds.
+   */
+  void flush();
+
+  /**
+   * Make progress: send any buffers which have met a flush
+   * threshold, complete sends, and receive and handle any messages
+   * which have arrived.
+   *
+   * Returns true if any message was handled.
+   */
+  bool poll();
+
+  /**
+   * Keep making progress until every message sent on any processor
+   * has been handled.  Must be called on every processor.
+   */
+  void quiesce();
+
+  /**
+   * Flush a destination's buffer once it holds \p n messages.
+   */
+  void flush_size(std::size_t n) { _flush_size = n; }
+  std::size_t flush_size() const { return _flush_size; }
+
+  /**
+   * Flush a destination's buffer once its oldest message has waited
+   * for \p delay.
+   */
+  void flush_delay(std::chrono::microseconds delay) { _flush_delay = delay; }
+  std::chrono::microseconds flush_delay() const { return _flush_delay; }
+
+  /**
+   * The number of messages this processor has sent to other
+   * processors, and the number it has handled from other processors.
+   */
+  std::size_t n_sent() const { return _termination.n_sent(); }
+  std::size_t n_handled() const { return _termination.n_received(); }
+
+private:
+  typedef std::pair<unsigned int, Payload> message_type;
+  typedef std::chrono::steady_clock clock_type;
+
+  typedef std::integral_constant<bool,
+    std::is_base_of<DataType, StandardType<message_type>>::value> is_fixed_type;
+
+  void flush(processor_id_type dest_processor_id);
+
+  // Post a nonblocking send of \p data to \p dest_processor_id
+  void post_send(processor_id_type dest_processor_id,
+                 const std::vector<message_type> & data,
+                 Request & req,
+                 std::true_type /* is_fixed_type */);
+
+  void post_send(processor_id_type dest_processor_id,
+                 const std::vector<message_type> & data,
+                 Request & req,
+                 std::false_type /* is_fixed_type */);
+
+  // Start a nonblocking receive of any waiting message into \p data,
+  // returning true if there was one
+  bool possibly_receive(unsigned int & src_processor_id,
+                        std::vector<message_type> & data,
+                        Request & req,
+                        std::true_type /* is_fixed_type */);
+
+  bool possibly_receive(unsigned int & src_processor_id,
+                        std::vector<message_type> & data,
+                        Request & req,
+                        std::false_type /* is_fixed_type */);
+
+  void handle(processor_id_type src_processor_id,
+              message_type && message);
+
+  const Communicator & _comm;
+
+  const MessageTag _tag;
+
+  std::vector<handler_type> _handlers;
+
+  std::size_t _flush_size;
+
+  std::chrono::microseconds _flush_delay;
+
+  struct OutgoingBuffer
+  {
+    std::vector<message_type> data;
+    clock_type::time_point oldest;
+  };
+
+  // Buffered messages for each destination
+  std::vector<OutgoingBuffer> _outgoing;
+
+  // Messages to ourselves, waiting to be handled
+  std::deque<message_type> _local;
+
+  struct Batch
+  {
+    unsigned int pid = any_source;
+    Request request;
+    std::vector<message_type> data;
+  };
+
+  // Sends in flight
+  std::list<Batch> _sends;
+
+  // Receives in flight; the last entry is always an unused entry for
+  // the next receive to fill in
+  std::list<Batch> _receives;
+
+  TerminationDetector _termination;
+};
+
+
+
+// ------------------------------------------------------------
+// ActiveMessages member functions
+
+template <typename Payload>
+inline
+ActiveMessages<Payload>::ActiveMessages(const Communicator & comm) :
+  _comm(comm),
+  _tag(comm.get_unique_tag()),
+  _flush_size(1024),
+  _flush_delay(100),
+  _outgoing(comm.size()),
+  _termination(comm)
+{
+  _receives.emplace_back();
+}
+
+
+
+template <typename Payload>
+inline
+ActiveMessages<Payload>::~ActiveMessages()
+{
+  // Users should quiesce() before we're destroyed, but if they
+  // didn't we at least mustn't free buffers that MPI is still
+  // reading from.
+  for (auto & batch : _sends)
+    batch.request.wait();
+}
+
+
+
+template <typename Payload>
+inline
+unsigned int
+ActiveMessages<Payload>::add_handler(handler_type handler)
+{
+  _handlers.push_back(std::move(handler));
+  return cast_int<unsigned int>(_handlers.size() - 1);
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::send(processor_id_type dest_processor_id,
+                              unsigned int handler_id,
+                              Payload payload)
+{
+  timpi_assert_less(dest_processor_id, _comm.size());
+  timpi_assert_less(handler_id, _handlers.size());
+
+  if (dest_processor_id == _comm.rank())
+    {
+      _local.emplace_back(handler_id, std::move(payload));
+      return;
+    }
+
+  OutgoingBuffer & outgoing = _outgoing[dest_processor_id];
+
+  if (outgoing.data.empty())
+    outgoing.oldest = clock_type::now();
+
+  outgoing.data.emplace_back(handler_id, std::move(payload));
+
+  if (outgoing.data.size() >= _flush_size)
+    this->flush(dest_processor_id);
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::flush()
+{
+  for (processor_id_type p = 0; p != _comm.size(); ++p)
+    this->flush(p);
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::flush(processor_id_type dest_processor_id)
+{
+  OutgoingBuffer & outgoing = _outgoing[dest_processor_id];
+  if (outgoing.data.empty())
+    return;
+
+  _termination.sent(outgoing.data.size());
+
+  _sends.emplace_back();
+  Batch & batch = _sends.back();
+  batch.pid = dest_processor_id;
+  batch.data.swap(outgoing.data);
+
+  this->post_send(dest_processor_id, batch.data, batch.request,
+                  is_fixed_type());
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::post_send(processor_id_type dest_processor_id,
+                                   const std::vector<message_type> & data,
+                                   Request & req,
+                                   std::true_type)
+{
+  _comm.send(dest_processor_id, data,
+             StandardType<message_type>(data.data()), req, _tag);
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::post_send(processor_id_type dest_processor_id,
+                                   const std::vector<message_type> & data,
+                                   Request & req,
+                                   std::false_type)
+{
+  _comm.nonblocking_send_packed_range(dest_processor_id, (void *)(nullptr),
+                                      data.begin(), data.end(), req, _tag);
+}
+
+
+
+template <typename Payload>
+inline
+bool
+ActiveMessages<Payload>::possibly_receive(unsigned int & src_processor_id,
+                                          std::vector<message_type> & data,
+                                          Request & req,
+                                          std::true_type)
+{
+  return _comm.possibly_receive(src_processor_id, data,
+                                StandardType<message_type>(), req, _tag);
+}
+
+
+
+template <typename Payload>
+inline
+bool
+ActiveMessages<Payload>::possibly_receive(unsigned int & src_processor_id,
+                                          std::vector<message_type> & data,
+                                          Request & req,
+                                          std::false_type)
+{
+  return _comm.possibly_receive_packed_range
+    (src_processor_id, (void *)(nullptr),
+     std::inserter(data, data.end()), (message_type *)(nullptr), req,
+     _tag);
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::handle(processor_id_type src_processor_id,
+                                message_type && message)
+{
+  timpi_assert_less(message.first, _handlers.size());
+  _handlers[message.first](src_processor_id, std::move(message.second));
+}
+
+
+
+template <typename Payload>
+inline
+bool
+ActiveMessages<Payload>::poll()
+{
+  bool handled_any = false;
+
+  // Flush any buffers which have been waiting too long
+  const auto now = clock_type::now();
+  for (processor_id_type p = 0; p != _comm.size(); ++p)
+    if (!_outgoing[p].data.empty() &&
+        now - _outgoing[p].oldest >= _flush_delay)
+      this->flush(p);
+
+  // Retire completed sends
+  _sends.remove_if
+    ([](Batch & batch)
+     {
+       if (batch.request.test())
+         {
+           batch.request.wait();
+           return true;
+         }
+       return false;
+     });
+
+  // Start receiving anything that's arrived
+  if (_comm.size() > 1)
+    while (this->possibly_receive(_receives.back().pid,
+                                  _receives.back().data,
+                                  _receives.back().request,
+                                  is_fixed_type()))
+      _receives.emplace_back();
+
+  // Handle anything we've finished receiving.  Handlers may send
+  // more messages, but they can't receive, so we're not modifying
+  // _receives out from under ourselves here.
+  for (auto it = _receives.begin(); std::next(it) != _receives.end();)
+    {
+      if (it->request.test())
+        {
+          it->request.wait();
+          for (auto & message : it->data)
+            this->handle(it->pid, std::move(message));
+          _termination.received(it->data.size());
+          handled_any = true;
+          it = _receives.erase(it);
+        }
+      else
+        ++it;
+    }
+
+  // Handle anything we've sent to ourselves, including anything
+  // those handlers send to ourselves in turn
+  while (!_local.empty())
+    {
+      message_type message = std::move(_local.front());
+      _local.pop_front();
+      this->handle(_comm.rank(), std::move(message));
+      handled_any = true;
+    }
+
+  return handled_any;
+}
+
+
+
+template <typename Payload>
+inline
+void
+ActiveMessages<Payload>::quiesce()
+{
+  // This function must be run on all processors at once
+  timpi_parallel_only(_comm);
+
+  _termination.reset();
+
+  do
+    {
+      // Get all our local work off our hands before polling, since
+      // the detector may start a new wave which must not miss any
+      // messages we were about to send
+      this->flush();
+      while (this->poll())
+        this->flush();
+    }
+  while (!_termination.poll());
+
+  // Everything we sent has been handled, so our sends are done
+  for (auto & batch : _sends)
+    batch.request.wait();
+  _sends.clear();
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_ACTIVE_MESSAGES_H
@@ -0,0 +1,336 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef TIMPI_COMMUNICATION_MATRIX_H
+#define TIMPI_COMMUNICATION_MATRIX_H
+
+// Local Includes
+#include "timpi/parallel_implementation.h"
+
+// C++ includes
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <string>
+#include <tuple>
+#include <utility>     // pair
+#include <vector>
+
+
+namespace TIMPI {
+
+//------------------------------------------------------------------------
+/**
+ * Records how many messages, and how many bytes, this processor
+ * sends to each other processor in push_parallel_vector_data,
+ * push_parallel_packed_range, and pull_parallel_vector_data, with
+ * entries grouped by a user-chosen label for each exchange.
+ *
+ * Recording is opt-in: exchanges are only counted while a Recording
+ * object for a matrix is in scope on the calling thread, e.g.
+ *
+ * \verbatim
+ * CommunicationMatrix matrix;
+ * {
+ *   CommunicationMatrix::Recording recording(matrix, "ghost sync");
+ *   push_parallel_vector_data(comm, data, act_on_data);
+ * }
+ * matrix.write_csv(comm, std::cout);
+ * \endverbatim
+ *
+ * Sends to self are not counted, since they never reach the
+ * network.  Byte counts are sizes of the data sent, or of the packed
+ * buffers (before any compression) for variable-size types, and
+ * don't include MPI overhead.
+ */
+class CommunicationMatrix
+{
+public:
+  struct Entry
+  {
+    std::size_t messages = 0;
+    std::size_t bytes = 0;
+  };
+
+  // Local row: label -> destination -> entry
+  typedef std::map<std::string, std::map<processor_id_type, Entry>> row_type;
+
+  // Whole matrix: label -> (source, destination) -> entry
+  typedef std::map<std::string,
+                   std::map<std::pair<processor_id_type, processor_id_type>,
+                            Entry>> matrix_type;
+
+  /**
+   * While in scope, records exchanges on this thread into \p matrix
+   * under \p label.  Recordings may be nested; the innermost one
+   * wins.
+   */
+  class Recording
+  {
+  public:
+    Recording(CommunicationMatrix & matrix, std::string label);
+
+    ~Recording();
+
+    Recording(const Recording &) = delete;
+    Recording & operator=(const Recording &) = delete;
+
+  private:
+    friend class CommunicationMatrix;
+
+    CommunicationMatrix & _matrix;
+    const std::string _label;
+    Recording * const _parent;
+  };
+
+  /**
+   * Count one message of \p bytes bytes to \p dest_processor_id
+   * under \p label.
+   */
+  void record(const std::string & label,
+              processor_id_type dest_processor_id,
+              std::size_t bytes);
+
+  /**
+   * Count one message of \p bytes bytes to \p dest_processor_id in
+   * the innermost active Recording on this thread, if any.
+   */
+  static void record_send(processor_id_type dest_processor_id,
+                          std::size_t bytes);
+
+  /**
+   * Returns true if a Recording is active on this thread, so callers
+   * can avoid computing message sizes otherwise.
+   */
+  static bool recording() { return current_recording() != nullptr; }
+
+  /**
+   * This processor's row of the matrix.
+   */
+  const row_type & local() const { return _local; }
+
+  void clear() { _local.clear(); }
+
+  /**
+   * Collects every processor's row onto processor \p root_id, which
+   * returns the full matrix; other processors return an empty one.
+   * Collective.
+   */
+  matrix_type gather(const Communicator & comm,
+                     processor_id_type root_id = 0) const;
+
+  /**
+   * Gathers the matrix and writes it to \p os on processor \p
+   * root_id, as CSV with one "label,source,destination,messages,bytes"
+   * line per nonzero entry.  Collective.
+   */
+  void write_csv(const Communicator & comm,
+                 std::ostream & os,
+                 processor_id_type root_id = 0) const;
+
+  /**
+   * Gathers the matrix and writes it to \p os on processor \p
+   * root_id, as a JSON object mapping each label to a list of
+   * {"source", "destination", "messages", "bytes"} entries.
+   * Collective.
+   */
+  void write_json(const Communicator & comm,
+                  std::ostream & os,
+                  processor_id_type root_id = 0) const;
+
+private:
+  static Recording *& current_recording();
+
+  row_type _local;
+};
+
+
+
+// ------------------------------------------------------------
+// CommunicationMatrix member functions
+
+inline
+CommunicationMatrix::Recording::Recording(CommunicationMatrix & matrix,
+                                          std::string label) :
+  _matrix(matrix),
+  _label(std::move(label)),
+  _parent(current_recording())
+{
+  current_recording() = this;
+}
+
+
+
+inline
+CommunicationMatrix::Recording::~Recording()
+{
+  current_recording() = _parent;
+}
+
+
+
+inline
+CommunicationMatrix::Recording *&
+CommunicationMatrix::current_recording()
+{
+  static thread_local Recording * current = nullptr;
+  return current;
+}
+
+
+
+inline
+void
+CommunicationMatrix::record(const std::string & label,
+                            processor_id_type dest_processor_id,
+                            std::size_t bytes)
+{
+  Entry & entry = _local[label][dest_processor_id];
+  ++entry.messages;
+  entry.bytes += bytes;
+}
+
+
+
+inline
+void
+CommunicationMatrix::record_send(processor_id_type dest_processor_id,
+                                 std::size_t bytes)
+{
+  Recording * recording = current_recording();
+  if (recording)
+    recording->_matrix.record(recording->_label, dest_processor_id, bytes);
+}
+
+
+
+inline
+CommunicationMatrix::matrix_type
+CommunicationMatrix::gather(const Communicator & comm,
+                            processor_id_type root_id) const
+{
+  typedef std::tuple<std::string, processor_id_type, processor_id_type,
+                     std::size_t, std::size_t> flat_entry;
+
+  const processor_id_type rank = comm.rank();
+
+  std::vector<flat_entry> entries;
+  for (const auto & label_row : _local)
+    for (const auto & dest_entry : label_row.second)
+      entries.emplace_back(label_row.first, rank, dest_entry.first,
+                           dest_entry.second.messages,
+                           dest_entry.second.bytes);
+
+  comm.gather(root_id, entries);
+
+  matrix_type matrix;
+  if (rank != root_id)
+    return matrix;
+
+  for (const auto & e : entries)
+    {
+      Entry & entry = matrix[std::get<0>(e)]
+        [std::make_pair(std::get<1>(e), std::get<2>(e))];
+      entry.messages += std::get<3>(e);
+      entry.bytes += std::get<4>(e);
+    }
+
+  return matrix;
+}
+
+
+
+inline
+void
+CommunicationMatrix::write_csv(const Communicator & comm,
+                               std::ostream & os,
+                               processor_id_type root_id) const
+{
+  const matrix_type matrix = this->gather(comm, root_id);
+  if (comm.rank() != root_id)
+    return;
+
+  os << "label,source,destination,messages,bytes\n";
+  for (const auto & label_entries : matrix)
+    for (const auto & pids_entry : label_entries.second)
+      {
+        // Quote labels, doubling any quotes, in case of commas
+        os << '"';
+        for (const char c : label_entries.first)
+          {
+            if (c == '"')
+              os << '"';
+            os << c;
+          }
+        os << "\"," << pids_entry.first.first
+           << ',' << pids_entry.first.second
+           << ',' << pids_entry.second.messages
+           << ',' << pids_entry.second.bytes << '\n';
+      }
+}
+
+
+
+inline
+void
+CommunicationMatrix::write_json(const Communicator & comm,
+                                std::ostream & os,
+                                processor_id_type root_id) const
+{
+  const matrix_type matrix = this->gather(comm, root_id);
+  if (comm.rank() != root_id)
+    return;
+
+  os << '{';
+  bool first_label = true;
+  for (const auto & label_entries : matrix)
+    {
+      if (!first_label)
+        os << ',';
+      first_label = false;
+
+      os << "\n  \"";
+      for (const char c : label_entries.first)
+        {
+          if (c == '"' || c == '\\')
+            os << '\\';
+          os << c;
+        }
+      os << "\": [";
+
+      bool first_entry = true;
+      for (const auto & pids_entry : label_entries.second)
+        {
+          if (!first_entry)
+            os << ',';
+          first_entry = false;
+
+          os << "\n    {\"source\": " << pids_entry.first.first
+             << ", \"destination\": " << pids_entry.first.second
+             << ", \"messages\": " << pids_entry.second.messages
+             << ", \"bytes\": " << pids_entry.second.bytes << '}';
+        }
+      os << "\n  ]";
+    }
+  os << "\n}\n";
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_COMMUNICATION_MATRIX_H
@@ -21,7 +21,10 @@
 #define TIMPI_PARALLEL_SYNC_H
 
 // Local Includes
+#include "timpi/communication_matrix.h"
 #include "timpi/parallel_implementation.h"
+#include "timpi/sync_timers.h"
+#include "timpi/window.h"
 
 // C++ includes
 #include <algorithm>   // max
@@ -142,6 +145,38 @@ void pull_parallel_vector_data(const Communicator & comm,
                                const ActionFunctor & act_on_data,
                                const datum * example);
 
+/**
+ * Fetch vectors of data by index from arrays owned by each
+ * processor, then act on them.
+ *
+ * This is the special case of the above in which gather_data would
+ * just look up each query id in an array, \p owned_data, on the
+ * queried processor.  Rather than sending queries and responses,
+ * each processor exposes its array in an MPI window and requesters
+ * fetch from it directly with one-sided MPI_Get, so owners do no work
+ * and there is no response round.
+ *
+ * The \p queries map is indexed by processor ids as keys, and for
+ * each processor id in the map there should be a vector of indices
+ * into that processor's \p owned_data.
+ *
+ * Answer data from each query will be operated on by
+ * act_on_data(processor_id_type pid, const std::vector<id> & ids,
+ *             std::vector<datum> & data);
+ *
+ * \p datum must have a fixed StandardType.  This is collective, even
+ * for processors with no queries, and \p owned_data must not change
+ * until every processor is done with it, i.e. until it returns.
+ */
+template <typename datum,
+          typename A,
+          typename MapToVectors,
+          typename ActionFunctor>
+void pull_parallel_vector_data(const Communicator & comm,
+                               const MapToVectors & queries,
+                               const std::vector<datum,A> & owned_data,
+                               const ActionFunctor & act_on_data);
+
 /**
  * Send and receive and act on vectors of data. Similar to
  * push_parallel_vector_data, except the vectors are packed and unpacked
@@ -229,6 +264,85 @@ empty_send_assertion (const Communicator & comm,
 }
 #endif
 
+// The number of bytes in fixed-size data, for CommunicationMatrix
+template <typename T>
+inline
+typename std::enable_if<!Has_buffer_type<Packing<T>>::value,
+                        std::size_t>::type
+data_bytes (const T &)
+{
+  return sizeof(T);
+}
+
+
+// Variable-size data is sent packed, so we count the size of its
+// packed buffer
+template <typename T>
+inline
+typename std::enable_if<Has_buffer_type<Packing<T>>::value,
+                        std::size_t>::type
+data_bytes (const T & t)
+{
+  return Packing<T>::packable_size(t, (void *)nullptr) *
+    sizeof(typename Packing<T>::buffer_type);
+}
+
+
+template <typename T, typename A>
+inline
+std::size_t
+data_bytes (const std::vector<T,A> & v)
+{
+  std::size_t bytes = 0;
+  for (const auto & entry : v)
+    bytes += data_bytes(entry);
+  return bytes;
+}
+
+
+// The number of bytes in packed data, for CommunicationMatrix
+template <typename Context, typename Container>
+inline
+std::size_t
+packed_data_bytes (const Context * context,
+                   const Container & c)
+{
+  typedef typename std::remove_const<typename Container::value_type>::type T;
+
+  std::size_t buffer_size = 0;
+  for (const auto & entry : c)
+    buffer_size += Packing<T>::packable_size(entry, context);
+  return buffer_size * sizeof(typename Packing<T>::buffer_type);
+}
+
+
+// Count the messages we're about to send in \p data in any active
+// CommunicationMatrix recording
+template <typename MapToContainers,
+          typename SizeFunctor>
+inline
+void
+record_communication (const Communicator & comm,
+                      const MapToContainers & data,
+                      const SizeFunctor & size_of)
+{
+  if (!CommunicationMatrix::recording())
+    return;
+
+  const processor_id_type num_procs = comm.size();
+
+  for (const auto & datapair : data)
+    {
+      const processor_id_type dest_pid = datapair.first % num_procs;
+      if (datapair.second.empty() || dest_pid == comm.rank())
+        continue;
+
+      CommunicationMatrix::record_send(dest_pid, size_of(datapair.second));
+    }
+}
+
+
+
 template <typename MapToContainers,
           typename SendFunctor,
           typename PossiblyReceiveFunctor,
@@ -249,16 +363,16 @@ push_parallel_nbx_helper(const Communicator & comm,
   // This function implements the "NBX" algorithm from
   // https://htor.inf.ethz.ch/publications/img/hoefler-dsde-protocols.pdf
 
+  SyncTimers::count_sync();
+
   // We'll grab a tag so we can overlap request sends and receives
   // without confusing one for the other
   const auto tag = comm.get_unique_tag();
 
-  // Save off the old send_mode so we can restore it after this
-  const auto old_send_mode = comm.send_mode();
-
-  // Set the sending to synchronous - this is so that we can know when
-  // the sends are complete
-  const_cast<Communicator &>(comm).send_mode(Communicator::SYNCHRONOUS);
+  // The send_functor must post *synchronous* sends - this is so that
+  // we can know when the sends are complete.  We leave that to the
+  // functor rather than changing comm.send_mode(), so that other
+  // threads can use the same Communicator concurrently.
 
   // The send requests
   std::list<Request> send_requests;
@@ -292,9 +406,13 @@ push_parallel_nbx_helper(const Communicator & comm,
 
       // Just act on data if the user requested a send-to-self
       if (dest_pid == comm.rank())
-        act_on_data(dest_pid, std::move(datum));
+        {
+          SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
+          act_on_data(dest_pid, std::move(datum));
+        }
       else
         {
+          SyncTimers::PhaseTimer posting(SyncTimers::SEND_POST);
           send_requests.emplace_back();
           send_functor(dest_pid, datum, send_requests.back(), tag);
         }
@@ -346,6 +464,10 @@ push_parallel_nbx_helper(const Communicator & comm,
       return false;
   };
 
+  // Until our own sends are done we're waiting on the network;
+  // after that we're waiting on other processors to finish theirs.
+  SyncTimers::PhaseTimer waiting(SyncTimers::RECEIVE_WAIT);
+
   // Keep looking for receives
   while (true)
     {
@@ -377,6 +499,7 @@ push_parallel_nbx_helper(const Communicator & comm,
                 info.request.wait();
 
                 // Act on the data
+                SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
                 act_on_data(info.src_pid, std::move(info.data));
 
                 // This removes it from the list
@@ -416,6 +539,7 @@ push_parallel_nbx_helper(const Communicator & comm,
         {
           started_barrier = true;
           comm.nonblocking_barrier(barrier_request);
+          waiting.switch_to(SyncTimers::BARRIER_WAIT);
         }
 
       // There is no data to act on (we reserve a single value in
@@ -432,9 +556,6 @@ push_parallel_nbx_helper(const Communicator & comm,
   // There better not be anything left at this point
   timpi_assert(!possibly_receive());
 
-  // Reset the send mode
-  const_cast<Communicator &>(comm).send_mode(old_send_mode);
-
   // So, *did* we see any empty containers being sent?
 #ifndef NDEBUG
   empty_send_assertion(comm, empty_target_pid);
@@ -462,6 +583,8 @@ push_parallel_alltoall_helper(const Communicator & comm,
   // NBX.  Every processor will know exactly how many receives to
   // post.
 
+  SyncTimers::count_sync();
+
   processor_id_type num_procs = comm.size();
 
   // Don't give us empty vectors to send.  We'll yell at you (after
@@ -496,7 +619,10 @@ push_parallel_alltoall_helper(const Communicator & comm,
     }
 
   // Tell everyone about where everyone will send to
-  comm.alltoall(will_send_to);
+  {
+    SyncTimers::PhaseTimer synchronizing(SyncTimers::BARRIER_WAIT);
+    comm.alltoall(will_send_to);
+  }
 
   // will_send_to now represents how many vectors we'll receive from
   // each processor; give it a better name.
@@ -525,11 +651,13 @@ push_parallel_alltoall_helper(const Communicator & comm,
       // Just act on data if the user requested a send-to-self
       if (destid == comm.rank())
         {
+          SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
           act_on_data(destid, std::move(datum));
           n_receives--;
         }
       else
         {
+          SyncTimers::PhaseTimer posting(SyncTimers::SEND_POST);
           requests.emplace_back();
           send_functor(destid, datum, requests.back(), tag);
         }
@@ -539,6 +667,8 @@ push_parallel_alltoall_helper(const Communicator & comm,
   if (num_procs == 1)
     return;
 
+  SyncTimers::PhaseTimer waiting(SyncTimers::RECEIVE_WAIT);
+
   // Post all of the receives.
   for (processor_id_type i = 0; i != n_receives; ++i)
     {
@@ -548,6 +678,8 @@ push_parallel_alltoall_helper(const Communicator & comm,
 
       container_type received_data;
       receive_functor(proc_id, received_data, tag);
+
+      SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
       act_on_data(proc_id, std::move(received_data));
     }
 
@@ -580,6 +712,8 @@ push_parallel_roundrobin_helper(const Communicator & comm,
   // synchronous.  Every processor talks to every other.  Only use this for
   // debugging, and only when you're desperate.
 
+  SyncTimers::count_sync();
+
   unsigned int num_procs = comm.size();
 
   // Don't give us empty vectors to send.  We'll yell at you (after
@@ -608,7 +742,10 @@ push_parallel_roundrobin_helper(const Communicator & comm,
         }
     }
 
-  comm.max(n_exchanges);
+  {
+    SyncTimers::PhaseTimer synchronizing(SyncTimers::BARRIER_WAIT);
+    comm.max(n_exchanges);
+  }
 
   // We'll grab a tag so responses and queries won't be confused when
   // this is used within a pull
@@ -632,13 +769,19 @@ push_parallel_roundrobin_helper(const Communicator & comm,
           &empty_container : &data_it->second;
 
         container_type received_data;
-        sendreceive_functor(procup, *data_to_send,
-                            procdown, received_data, tag);
+        {
+          SyncTimers::PhaseTimer waiting(SyncTimers::RECEIVE_WAIT);
+          sendreceive_functor(procup, *data_to_send,
+                              procdown, received_data, tag);
+        }
 
         // Empty containers aren't *real* data, they're an artifact of
         // doing send_receive with everyone.  Just skip them.
         if (!received_data.empty())
-          act_on_data(procdown, std::move(received_data));
+          {
+            SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
+            act_on_data(procdown, std::move(received_data));
+          }
       }
 
   // So, *did* we see any empty containers being sent?
@@ -664,6 +807,10 @@ void push_parallel_packed_range(const Communicator & comm,
   typedef typename container_type::value_type nonref_type;
   typename std::remove_const<nonref_type>::type * output_type = nullptr;
 
+  detail::record_communication
+    (comm, data, [&context](const container_type & datum)
+                 { return detail::packed_data_bytes(context, datum); });
+
   switch (comm.sync_type()) {
   case Communicator::NBX:
     {
@@ -671,7 +818,10 @@ void push_parallel_packed_range(const Communicator & comm,
                                             const container_type & datum,
                                             Request & send_request,
                                             const MessageTag tag) {
-        comm.nonblocking_send_packed_range(dest_pid, context, datum.begin(), datum.end(), send_request, tag);
+        // NBX needs synchronous sends, so that send completion means
+        // the receiver has seen the message
+        comm.nonblocking_send_packed_range(dest_pid, context, datum.begin(), datum.end(), send_request, tag,
+                                           Communicator::SYNCHRONOUS);
       };
 
       auto possibly_receive_functor = [&context, &output_type, &comm](unsigned int & current_src_proc,
@@ -704,7 +854,7 @@ void push_parallel_packed_range(const Communicator & comm,
                                                              container_type & current_incoming_data,
                                                              const MessageTag tag) {
         bool flag = false;
-        Status stat(comm.packed_range_probe<container_type>(current_src_proc, tag, flag));
+        Status stat(comm.packed_range_matched_probe<container_type>(current_src_proc, tag, flag));
         timpi_assert(flag);
 
         Request req;
@@ -766,6 +916,10 @@ void push_parallel_vector_data(const Communicator & comm,
   // to construct the user's data type without an example.
   auto type = build_standard_type(static_cast<nonconst_nonref_type *>(nullptr));
 
+  detail::record_communication
+    (comm, data, [](const container_type & datum)
+                 { return detail::data_bytes(datum); });
+
   switch (comm.sync_type()) {
   case Communicator::NBX:
     {
@@ -773,7 +927,10 @@ void push_parallel_vector_data(const Communicator & comm,
                                          const container_type & datum,
                                          Request & send_request,
                                          const MessageTag tag) {
-        comm.send(dest_pid, datum, type, send_request, tag);
+        // NBX needs synchronous sends, so that send completion means
+        // the receiver has seen the message
+        comm.send(dest_pid, datum, type, send_request, tag,
+                  Communicator::SYNCHRONOUS);
       };
 
       auto possibly_receive_functor = [&type, &comm](unsigned int & current_src_proc,
@@ -990,6 +1147,10 @@ void pull_parallel_vector_data(const Communicator & comm,
         }
       else
         {
+          CommunicationMatrix::record_send
+            (pid, detail::data_bytes(response));
+
+          SyncTimers::PhaseTimer posting(SyncTimers::SEND_POST);
           Request sendreq;
           comm.send(pid, response, sendreq, tag);
           response_requests.push_back(sendreq);
@@ -1007,6 +1168,8 @@ void pull_parallel_vector_data(const Communicator & comm,
   // non-blocking APIs with this data type.
   //
   // FIXME - implement Derek's API from #1684, switch to that!
+  SyncTimers::count_sync();
+  SyncTimers::PhaseTimer waiting(SyncTimers::RECEIVE_WAIT);
   std::vector<Request> receive_requests;
   std::vector<processor_id_type> receive_procids;
   for (std::size_t i = 0,
@@ -1023,12 +1186,74 @@ void pull_parallel_vector_data(const Communicator & comm,
       timpi_assert(queries.count(proc_id));
       auto & querydata = queries.at(proc_id);
       timpi_assert_equal_to(querydata.size(), received_data.size());
+
+      SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
       act_on_data(proc_id, querydata, received_data);
     }
 
   wait(response_requests);
 }
 
+
+
+template <typename datum,
+          typename A,
+          typename MapToVectors,
+          typename ActionFunctor>
+void pull_parallel_vector_data(const Communicator & comm,
+                               const MapToVectors & queries,
+                               const std::vector<datum,A> & owned_data,
+                               const ActionFunctor & act_on_data)
+{
+  SyncTimers::count_sync();
+
+  // We only read through the window, so we can expose const data
+  Window<datum> window(comm, const_cast<datum *>(owned_data.data()),
+                       owned_data.size());
+
+  // One response per query, kept in query order
+  std::vector<std::vector<datum>> responses(queries.size());
+
+  {
+    SyncTimers::PhaseTimer posting(SyncTimers::SEND_POST);
+
+    window.lock_all();
+
+    std::size_t i = 0;
+    for (const auto & query : queries)
+      {
+        const processor_id_type pid = query.first;
+        const auto & ids = query.second;
+        std::vector<datum> & response = responses[i++];
+
+        timpi_assert_less(pid, comm.size());
+
+        response.resize(ids.size());
+
+        // No need for MPI to fetch our own data
+        if (pid == comm.rank())
+          for (std::size_t j = 0, n = ids.size(); j != n; ++j)
+            {
+              timpi_assert_less(std::size_t(ids[j]), owned_data.size());
+              response[j] = owned_data[ids[j]];
+            }
+        else
+          window.get(pid, ids, response.data());
+      }
+  }
+
+  {
+    SyncTimers::PhaseTimer waiting(SyncTimers::RECEIVE_WAIT);
+    window.unlock_all();
+  }
+
+  SyncTimers::PhaseTimer acting(SyncTimers::ACT_ON_DATA);
+
+  std::size_t i = 0;
+  for (const auto & query : queries)
+    act_on_data(query.first, query.second, responses[i++]);
+}
+
 } // namespace TIMPI
 
 #endif // TIMPI_PARALLEL_SYNC_H
@@ -0,0 +1,137 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_BUFFER_ALLOCATOR_H
+#define TIMPI_BUFFER_ALLOCATOR_H
+
+// C++ includes
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * The source of memory for the temporary buffers a Communicator
+ * allocates internally, e.g. to stage nested vectors for MPI_Pack,
+ * to assemble gathered data, or to pair values with ranks in
+ * minloc/maxloc.
+ *
+ * The default implementation just uses the heap.  Subclass it to put
+ * those buffers in huge pages, in NUMA-local memory, or in memory
+ * already registered with the network, then hand an instance to
+ * Communicator::buffer_allocator().
+ *
+ * Buffers can be allocated on one thread and freed on another, and
+ * can outlive the Communicator, so implementations should be
+ * thread-safe and shouldn't depend on it.
+ */
+class BufferAllocator
+{
+public:
+  virtual ~BufferAllocator() = default;
+
+  /**
+   * Returns \p bytes bytes of memory aligned to at least \p
+   * alignment, or throws std::bad_alloc.
+   */
+  virtual void * allocate(std::size_t bytes, std::size_t alignment);
+
+  /**
+   * Frees memory returned by allocate() with the same \p bytes and \p
+   * alignment.
+   */
+  virtual void deallocate(void * p, std::size_t bytes, std::size_t alignment);
+
+  /**
+   * The allocator every Communicator starts out with.
+   */
+  static std::shared_ptr<BufferAllocator> default_allocator();
+};
+
+
+
+/**
+ * A standard-library allocator drawing from a BufferAllocator, so
+ * that internal buffers can still be std::vector.
+ */
+template <typename T>
+class InternalAllocator
+{
+public:
+  typedef T value_type;
+
+  explicit InternalAllocator(std::shared_ptr<BufferAllocator> allocator =
+                               BufferAllocator::default_allocator()) :
+    _allocator(std::move(allocator)) {}
+
+  template <typename U>
+  InternalAllocator(const InternalAllocator<U> & other) :
+    _allocator(other.buffer_allocator()) {}
+
+  T * allocate(std::size_t n)
+  { return static_cast<T *>(_allocator->allocate(n * sizeof(T), alignof(T))); }
+
+  void deallocate(T * p, std::size_t n)
+  { _allocator->deallocate(p, n * sizeof(T), alignof(T)); }
+
+  /**
+   * Default-initializes, rather than value-initializes, new entries,
+   * so that sizing a buffer doesn't zero-fill (and touch every page
+   * of) memory which is about to be overwritten anyway.
+   */
+  template <typename U>
+  void construct(U * p)
+    noexcept(std::is_nothrow_default_constructible<U>::value)
+  { ::new(static_cast<void *>(p)) U; }
+
+  const std::shared_ptr<BufferAllocator> & buffer_allocator() const
+  { return _allocator; }
+
+private:
+  std::shared_ptr<BufferAllocator> _allocator;
+};
+
+template <typename T, typename U>
+inline bool operator== (const InternalAllocator<T> & a,
+                        const InternalAllocator<U> & b)
+{
+  return a.buffer_allocator() == b.buffer_allocator();
+}
+
+template <typename T, typename U>
+inline bool operator!= (const InternalAllocator<T> & a,
+                        const InternalAllocator<U> & b)
+{
+  return !(a == b);
+}
+
+
+/**
+ * The type of the temporary buffers Communicator allocates for itself.
+ */
+template <typename T>
+using InternalBuffer = std::vector<T, InternalAllocator<T>>;
+
+} // namespace TIMPI
+
+#endif // TIMPI_BUFFER_ALLOCATOR_H
@@ -0,0 +1,293 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_BUFFER_POOL_H
+#define TIMPI_BUFFER_POOL_H
+
+// TIMPI includes
+#include "timpi/buffer_allocator.h"
+
+// C++ includes
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * A cache of heap-allocated std::vector buffers, for the temporary
+ * send and receive buffers which Communicator operations would
+ * otherwise allocate and free on every call.  Buffers are grouped by
+ * vector type and by power-of-two capacity class, so a request is
+ * served by a buffer no more than four times larger than it needs.
+ *
+ * Buffers with an InternalAllocator, the default, get their memory
+ * from the pool's allocator().  Buffers with other allocators, e.g.
+ * the std::vector<buffer_type> that Packing requires, are pooled too.
+ *
+ * The pool keeps at most max_cached_bytes() of capacity, and at most
+ * max_buffers_per_class() buffers of each type and class; buffers
+ * released beyond those caps are freed.  Setting max_cached_bytes(0)
+ * disables caching entirely.
+ *
+ * Each Communicator owns one pool, shared with any Request still
+ * holding a buffer from it.  Acquiring and releasing are thread-safe.
+ */
+class BufferPool
+{
+public:
+  BufferPool(std::size_t max_cached_bytes = 32 << 20,
+             std::size_t max_buffers_per_class = 8,
+             std::shared_ptr<BufferAllocator> allocator =
+               BufferAllocator::default_allocator());
+
+  ~BufferPool();
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool & operator=(const BufferPool &) = delete;
+
+  /**
+   * Returns a heap-allocated vector of size \p size, reusing a cached
+   * buffer if one is big enough.  The contents of the buffer are
+   * unspecified, as with any uninitialized receive buffer; with an
+   * InternalAllocator, new entries are default-initialized, so
+   * trivial types aren't zeroed.  The caller owns the vector until
+   * handing it back with release(), or deleting it; a PooledBuffer
+   * does that automatically.
+   *
+   * With \p size == 0, e.g. for a buffer which will be filled by
+   * appending, the largest cached buffer of type T is reused, to
+   * avoid reallocations as it grows.
+   */
+  template <typename T, typename A = InternalAllocator<T>>
+  std::vector<T,A> * acquire(std::size_t size);
+
+  /**
+   * Returns \p buffer to the pool, or deletes it if the pool is full
+   * or if the buffer came from an allocator we no longer use.
+   */
+  template <typename T, typename A>
+  void release(std::vector<T,A> * buffer);
+
+  /**
+   * Sets the allocator which InternalBuffer memory comes from.  This
+   * frees every cached buffer; buffers still in use are freed by the
+   * allocator they came from when they are released.
+   */
+  void allocator(std::shared_ptr<BufferAllocator> allocator);
+
+  std::shared_ptr<BufferAllocator> allocator() const;
+
+  /**
+   * Frees every cached buffer.
+   */
+  void clear();
+
+  /**
+   * Sets the maximum total capacity, in bytes, of cached buffers.
+   * Shrinking this frees cached buffers as needed.
+   */
+  void max_cached_bytes(std::size_t bytes);
+
+  std::size_t max_cached_bytes() const;
+
+  /**
+   * Sets the maximum number of buffers cached for each element type
+   * and capacity class.
+   */
+  void max_buffers_per_class(std::size_t n);
+
+  std::size_t max_buffers_per_class() const;
+
+  /**
+   * Counters describing how well the pool is doing.
+   */
+  struct Statistics
+  {
+    // Calls to acquire(), and how many of them reused a buffer
+    std::size_t acquires = 0;
+    std::size_t reuses = 0;
+
+    // Calls to release(), and how many of them freed the buffer
+    std::size_t releases = 0;
+    std::size_t discards = 0;
+
+    // What we're holding on to right now
+    std::size_t cached_buffers = 0;
+    std::size_t cached_bytes = 0;
+  };
+
+  Statistics statistics() const;
+
+private:
+  // A cached buffer, with what we need to free it without knowing
+  // its type
+  struct CachedBuffer
+  {
+    void * buffer;
+    std::size_t capacity_bytes;
+    void (*destroy)(void *);
+  };
+
+  template <typename Vector>
+  static void destroy(void * buffer)
+  { delete static_cast<Vector *>(buffer); }
+
+  // The allocator for a new buffer, and whether an old buffer still
+  // uses the allocator we would give it
+  template <typename A>
+  A make_allocator(const A *) const { return A(); }
+
+  template <typename T>
+  InternalAllocator<T> make_allocator(const InternalAllocator<T> *) const
+  { return InternalAllocator<T>(this->allocator()); }
+
+  template <typename T, typename A>
+  bool current_allocator(const std::vector<T,A> &) const { return true; }
+
+  template <typename T>
+  bool current_allocator(const InternalBuffer<T> & buffer) const
+  { return buffer.get_allocator().buffer_allocator() == this->allocator(); }
+
+  // Type-erased implementations of acquire() and release()
+  void * take(std::type_index type, std::size_t bytes);
+
+  bool give(std::type_index type, const CachedBuffer & cached);
+
+  // Frees cached buffers until we're within our caps; requires the
+  // lock to be held
+  void shrink_to_caps();
+
+  // Frees every cached buffer; requires the lock to be held
+  void clear_cache();
+
+  // Buffers are grouped by vector type and capacity class, the floor
+  // of the log2 of their capacity in bytes
+  typedef std::pair<std::type_index, unsigned int> class_key;
+
+  std::map<class_key, std::vector<CachedBuffer>> _cache;
+
+  std::size_t _max_cached_bytes;
+  std::size_t _max_buffers_per_class;
+
+  std::shared_ptr<BufferAllocator> _allocator;
+
+  Statistics _statistics;
+
+  mutable std::mutex _mutex;
+};
+
+
+
+
+/**
+ * Holds a buffer acquired from a BufferPool, and releases it back to
+ * the pool when destroyed, so that an exception thrown while the
+ * buffer is in use doesn't leak it.  Call release() to hand the
+ * buffer on instead, e.g. to a PostWaitReleaseBuffer.
+ */
+template <typename T, typename A = InternalAllocator<T>>
+class PooledBuffer
+{
+public:
+  PooledBuffer(BufferPool & pool, std::size_t size) :
+    _pool(pool), _buffer(pool.acquire<T,A>(size)) {}
+
+  ~PooledBuffer() { _pool.release(_buffer); }
+
+  PooledBuffer(const PooledBuffer &) = delete;
+  PooledBuffer & operator=(const PooledBuffer &) = delete;
+
+  std::vector<T,A> & operator* () const { return *_buffer; }
+
+  std::vector<T,A> * operator-> () const { return _buffer; }
+
+  /**
+   * Gives up ownership of the buffer, returning it.
+   */
+  std::vector<T,A> * release()
+  {
+    std::vector<T,A> * buffer = _buffer;
+    _buffer = nullptr;
+    return buffer;
+  }
+
+private:
+  BufferPool & _pool;
+
+  std::vector<T,A> * _buffer;
+};
+
+
+
+// ------------------------------------------------------------
+// BufferPool inline member functions
+template <typename T, typename A>
+inline
+std::vector<T,A> *
+BufferPool::acquire(std::size_t size)
+{
+  typedef std::vector<T,A> vector_type;
+
+  vector_type * buffer = static_cast<vector_type *>
+    (this->take(std::type_index(typeid(vector_type)), size * sizeof(T)));
+
+  if (!buffer)
+    return new vector_type
+      (size, this->make_allocator(static_cast<const A *>(nullptr)));
+
+  buffer->resize(size);
+  return buffer;
+}
+
+
+
+template <typename T, typename A>
+inline
+void
+BufferPool::release(std::vector<T,A> * buffer)
+{
+  typedef std::vector<T,A> vector_type;
+
+  if (!buffer)
+    return;
+
+  if (!this->current_allocator(*buffer))
+    {
+      delete buffer;
+      return;
+    }
+
+  const CachedBuffer cached
+    {buffer, buffer->capacity() * sizeof(T),
+     &BufferPool::destroy<vector_type>};
+
+  if (!this->give(std::type_index(typeid(vector_type)), cached))
+    delete buffer;
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_BUFFER_POOL_H
@@ -0,0 +1,102 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_BUFFERED_SEND_H
+#define TIMPI_BUFFERED_SEND_H
+
+// TIMPI includes
+#include "timpi/buffer_pool.h"
+#include "timpi/message_tag.h"
+#include "timpi/request.h"
+
+// C++ includes
+#include <cstddef>
+#include <memory>
+
+namespace TIMPI
+{
+
+// Forward declarations
+class Communicator;
+
+//-------------------------------------------------------------------
+/**
+ * The sends still in flight from Communicator::BUFFERED send mode.
+ *
+ * A buffered send copies its message into a buffer from the
+ * Communicator's BufferPool, posts a nonblocking send of the copy,
+ * and hands both to this process-wide queue, so the caller can
+ * return (or reuse its data) right away.  Buffers go back to their
+ * pools as their sends complete; the queue checks for that whenever
+ * enough new sends (or bytes) have been added since its last check,
+ * and waits for whatever is left when the last TIMPIInit exits.  The
+ * memory in use thus tracks the actual demand.
+ *
+ * We don't use MPI_Bsend: MPI allows only one attached buffer, and
+ * growing it means detaching it, which blocks until earlier buffered
+ * messages are delivered - a deadlock if their receivers are busy
+ * sending to us.
+ *
+ * "class" is a bit of a misnomer here; everything is static.
+ */
+class BufferedSends
+{
+public:
+  /**
+   * Takes ownership of a send request \p req posted from \p buffer,
+   * which goes back to \p pool once the send completes.  A copy of
+   * \p tag, from \p comm, is held until then too, so that the tag
+   * isn't reused while the message is still in flight.  Every so
+   * often, buffers and tags from earlier sends which have since
+   * completed are released first.
+   */
+  static void add(request req,
+                  std::shared_ptr<BufferPool> pool,
+                  InternalBuffer<char> * buffer,
+                  const MessageTag & tag,
+                  const Communicator & comm);
+
+  /**
+   * Drops the references which sends still in flight hold on unique
+   * tags from \p comm, which is being destroyed; those sends may
+   * outlive it.
+   */
+  static void release_tags(const Communicator & comm);
+
+  /**
+   * Releases the buffers of all completed sends, and returns how many
+   * sends are still in flight.
+   */
+  static std::size_t test();
+
+  /**
+   * Waits for every buffered send to complete.  Their receives must
+   * be posted for that to happen.
+   */
+  static void wait();
+
+  /**
+   * The total size, in bytes, of the buffers of sends not yet found
+   * to be complete.
+   */
+  static std::size_t pending_bytes();
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_BUFFERED_SEND_H
@@ -20,18 +20,24 @@
 #define TIMPI_COMMUNICATOR_H
 
 // TIMPI includes
+#include "timpi/buffer_pool.h"
+#include "timpi/buffered_send.h"
+#include "timpi/large_count.h"
 #include "timpi/message_tag.h"
 #include "timpi/packing.h"
 #include "timpi/request.h"
+#include "timpi/sorted_integer_encoding.h"
 #include "timpi/standard_type.h"
 #include "timpi/status.h"
 #include "timpi/timpi_config.h"
 #include "timpi/timpi_macros.h"
+#include "timpi/vector_subset.h"
 
 // C++ includes
 #include <cstdint>
 #include <map>
 #include <memory> // shared_ptr
+#include <mutex>
 #include <string>
 #include <vector>
 #include <type_traits>
@@ -164,9 +170,17 @@ public:
    */
   void duplicate(const communicator & comm);
 
-  communicator & get() { return _communicator; }
+  /**
+   * The underlying MPI communicator.  With multiple tag namespaces,
+   * this is the communicator (a duplicate of the original, for any
+   * namespace but 0) for the calling thread's namespace.
+   */
+  communicator & get()
+  { return _namespace_comms.empty() ? _communicator :
+      const_cast<communicator &>(this->namespace_comm()); }
 
-  const communicator & get() const { return _communicator; }
+  const communicator & get() const
+  { return _namespace_comms.empty() ? _communicator : this->namespace_comm(); }
 
   /**
    * Get a tag that is unique to this Communicator.  A requested tag
@@ -198,6 +212,42 @@ public:
    */
   void dereference_unique_tag(int tagvalue) const;
 
+  /**
+   * Split the automatic tag values of this Communicator into \p n
+   * disjoint namespaces, so that up to \p n threads can each request
+   * automatic tags (and run algorithms such as
+   * push_parallel_vector_data() which request them internally)
+   * concurrently on this one Communicator.  Each thread selects its
+   * namespace with thread_tag_namespace(); the sequence of automatic
+   * tag requests must then be consistent across processors within
+   * each namespace, rather than across the Communicator as a whole.
+   *
+   * With more than one namespace, tag bookkeeping is serialized
+   * internally, and MPI must have been initialized with
+   * MPI_THREAD_MULTIPLE support.
+   *
+   * This must be called consistently on every processor, while no
+   * other thread is using this Communicator.
+   */
+  void tag_namespaces(unsigned int n);
+
+  /**
+   * The number of automatic tag namespaces in this Communicator.
+   */
+  unsigned int tag_namespaces() const;
+
+  /**
+   * Select which namespace automatic tags requested by the calling
+   * thread are drawn from, for every Communicator it uses.  Defaults
+   * to namespace 0.
+   */
+  static void thread_tag_namespace(unsigned int ns);
+
+  /**
+   * The tag namespace selected by the calling thread.
+   */
+  static unsigned int thread_tag_namespace();
+
   /**
    * Free and reset this communicator
    */
@@ -215,15 +265,28 @@ public:
 #endif
 
   /**
-   * Whether to use default or synchronous sends?
+   * Whether to use default, synchronous, or buffered sends?
+   *
+   * BUFFERED sends copy each message and return without waiting
+   * for the receiver, even when nonblocking: the Request is complete
+   * at once, and BufferedSends frees the copy later.  This suits
+   * bursts of many small messages.
    */
-  enum SendMode { DEFAULT=0, SYNCHRONOUS };
+  enum SendMode { DEFAULT=0, SYNCHRONOUS, BUFFERED };
 
   /**
    * What algorithm to use for parallel synchronization?
    */
   enum SyncType { NBX, ALLTOALL_COUNTS, SENDRECEIVE };
 
+  /**
+   * What codec, if any, to use to compress packed range buffers?
+   * DELTA_VARINT suits buffers of slowly varying integers (ids,
+   * offsets, lengths); LZ suits buffers with repeated byte runs
+   * (strings, repeated records).
+   */
+  enum PackedCompression { NO_COMPRESSION=0, DELTA_VARINT, LZ };
+
 
 private:
 
@@ -237,14 +300,81 @@ private:
   processor_id_type _rank, _size;
   SendMode _send_mode;
   SyncType _sync_type;
+  PackedCompression _packed_compression;
+  std::size_t _packed_compression_threshold;
+  std::size_t _large_count_threshold;
+
+  // Temporary send and receive buffers, shared with any Request
+  // which still needs one
+  std::shared_ptr<BufferPool> _buffer_pool;
+
+  /**
+   * The communicator for the calling thread's tag namespace
+   */
+  const communicator & namespace_comm() const;
+
+  /**
+   * Free any communicators we duplicated for extra tag namespaces
+   */
+  void free_namespace_comms();
+
+  /**
+   * The automatic tag values handed out within one tag namespace.
+   */
+  struct TagRange
+  {
+    // Automatic tags come from [begin, end)
+    int begin, end;
+
+    // The next automatic tag we'll try to hand out
+    int next;
+
+#ifndef NDEBUG
+    // Running hash of every automatic tag handed out, and the number
+    // of automatic tags handed out, so we can cheaply verify every so
+    // often that all processors are still requesting tags in sync.
+    std::uint64_t hash;
+    std::size_t n_auto;
+#endif
+  };
+
+  /**
+   * Divide the automatic tag values into \p n equal namespaces,
+   * resetting each of them.
+   */
+  void reset_tag_ranges(unsigned int n);
+
+  /**
+   * Returns the first tag value at or after \p tagvalue which is not
+   * currently in use, wrapping around within \p range.
+   */
+  int next_free_tag(int tagvalue, const TagRange & range) const;
+
+  /**
+   * Returns a lock on our tag bookkeeping if we might be used by
+   * multiple threads at once, or an empty lock otherwise.
+   */
+  std::unique_lock<std::mutex> tag_lock() const;
+
+  // Reference counts for each tag currently in use.  Hashed rather
+  // than ordered, so lookups, insertions and releases are all O(1).
+  // Only ever accessed under tag_lock(), which does nothing unless
+  // we have multiple tag namespaces; otherwise, like the rest of
+  // TIMPI::, this isn't thread-safe.
+  mutable std::unordered_map<int, unsigned int> used_tag_values;
 
-  // mutable used_tag_values and tag_queue - not thread-safe, but then
-  // TIMPI:: isn't thread-safe in general.
-  mutable std::map<int, unsigned int> used_tag_values;
-  mutable int _next_tag;
+  // One range of automatic tags per tag namespace
+  mutable std::vector<TagRange> _tag_ranges;
+
+  // Duplicate communicators for tag namespaces 1 and up
+  std::vector<communicator> _namespace_comms;
 
   int _max_tag;
 
+  // Serializes tag bookkeeping when we have multiple tag namespaces;
+  // held by pointer so that we remain movable.
+  std::unique_ptr<std::mutex> _tag_mutex;
+
   // Keep track of duplicate/split operations so we know when to free
   bool _I_duped_it;
 
@@ -276,7 +406,8 @@ private:
    */
   template <typename Map,
             typename std::enable_if<std::is_base_of<DataType, StandardType<typename Map::key_type>>::value &&
-                                    std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value,
+                                    std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value &&
+                                    !HasSortedIntegerKeys<Map>::value,
                                     int>::type = 0>
   void map_broadcast(Map & data,
                      const unsigned int root_id,
@@ -290,12 +421,89 @@ private:
    */
   template <typename Map,
             typename std::enable_if<!(std::is_base_of<DataType, StandardType<typename Map::key_type>>::value &&
-                                      std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value),
+                                      std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value) &&
+                                    !HasSortedIntegerKeys<Map>::value,
+                                    int>::type = 0>
+  void map_broadcast(Map & data,
+                     const unsigned int root_id,
+                     const bool identical_sizes) const;
+
+  /**
+   * Private implementation function called by the map-based
+   * broadcast() specializations.  This HasSortedIntegerKeys variant
+   * broadcasts the keys delta encoded, which for dense id ranges is
+   * several times smaller, at the cost of one more (small) broadcast.
+   */
+  template <typename Map,
+            typename std::enable_if<HasSortedIntegerKeys<Map>::value,
                                     int>::type = 0>
   void map_broadcast(Map & data,
                      const unsigned int root_id,
                      const bool identical_sizes) const;
 
+  /**
+   * Private implementation function called by the std::set
+   * set_union() specializations; gathers to \p root_id, or to every
+   * processor if \p all_gather.
+   */
+  template <typename Set,
+            typename std::enable_if<!HasSortedIntegerKeys<Set>::value,
+                                    int>::type = 0>
+  void set_union_impl(Set & data,
+                      const unsigned int root_id,
+                      const bool all_gather) const;
+
+  /**
+   * Private implementation function called by the std::set
+   * set_union() specializations.  This HasSortedIntegerKeys variant
+   * gathers the keys delta encoded.
+   */
+  template <typename Set,
+            typename std::enable_if<HasSortedIntegerKeys<Set>::value,
+                                    int>::type = 0>
+  void set_union_impl(Set & data,
+                      const unsigned int root_id,
+                      const bool all_gather) const;
+
+  /**
+   * Private implementation function called by the std::set
+   * broadcast() specialization.
+   */
+  template <typename Set,
+            typename std::enable_if<!HasSortedIntegerKeys<Set>::value,
+                                    int>::type = 0>
+  void set_broadcast(Set & data,
+                     const unsigned int root_id,
+                     const bool identical_sizes) const;
+
+  /**
+   * Private implementation function called by the std::set
+   * broadcast() specialization.  This HasSortedIntegerKeys variant
+   * broadcasts the keys delta encoded.
+   */
+  template <typename Set,
+            typename std::enable_if<HasSortedIntegerKeys<Set>::value,
+                                    int>::type = 0>
+  void set_broadcast(Set & data,
+                     const unsigned int root_id,
+                     const bool identical_sizes) const;
+
+  /**
+   * Private implementation function called by the vector gather() and
+   * allgather() specializations: concatenates \p sendlengths[p]
+   * entries of \p type from \p sendbuf on each processor p into \p
+   * recvbuf on \p root_id, or on every processor if \p all_gather.
+   * Totals beyond large_count_threshold() are gathered with a
+   * broadcast or send per processor rather than one MPI_Gatherv.
+   */
+  template <typename T>
+  void gatherv_impl(const T * sendbuf,
+                    const std::vector<std::size_t> & sendlengths,
+                    T * recvbuf,
+                    const DataType & type,
+                    const unsigned int root_id,
+                    const bool all_gather) const;
+
   /**
    * Private implementation function called by the map-based max()
    * specializations.  This is_fixed_type variant saves a
@@ -324,6 +532,19 @@ private:
   std::size_t packed_size_of(const std::vector<std::vector<T,A1>,A2> & buf,
                              const DataType & type) const;
 
+  // Utility function for BUFFERED sends: copies the \p bytes bytes
+  // holding \p count entries of \p type at \p buf, sends the copy,
+  // and leaves it to BufferedSends to release, holding on to \p tag
+  // until the send completes.  A nonblocking send's \p req is complete
+  // at once.
+  void buffered_send(const void * buf,
+                     std::size_t bytes,
+                     CountType count,
+                     const data_type & type,
+                     const unsigned int dest_processor_id,
+                     const MessageTag & tag,
+                     request * req = nullptr) const;
+
   // Communication operations:
 public:
 
@@ -354,6 +575,80 @@ public:
    */
   SyncType sync_type() const { return _sync_type; }
 
+  /**
+   * Explicitly sets the \p PackedCompression codec used for packed
+   * range sends, receives, broadcasts and gathers, and for the
+   * parallel_sync exchanges built on them.  Buffers smaller than \p
+   * threshold_bytes, or which the codec fails to shrink, are sent
+   * uncompressed (but still framed).
+   *
+   * Every processor taking part in a packed range communication must
+   * be using the same codec setting, or at least all must agree on
+   * whether compression is on at all.
+   */
+  void packed_compression (const PackedCompression pc,
+                           std::size_t threshold_bytes = 4096)
+  { _packed_compression = pc; _packed_compression_threshold = threshold_bytes; }
+
+  /**
+   * Sets the packed range compression codec via a string: "none",
+   * "delta_varint" or "lz".
+   *
+   * Useful for changing the codec via a CLI arg or parameter.
+   */
+  void packed_compression (const std::string & pc);
+
+  /**
+   * Gets the user-requested PackedCompression.
+   */
+  PackedCompression packed_compression() const { return _packed_compression; }
+
+  /**
+   * Gets the size in bytes below which packed range buffers are not
+   * compressed.
+   */
+  std::size_t packed_compression_threshold() const
+  { return _packed_compression_threshold; }
+
+  /**
+   * The pool from which temporary send and receive buffers are drawn,
+   * e.g. for nested vectors and packed ranges.  Use it to adjust the
+   * caching limits, or to check its statistics.
+   */
+  BufferPool & buffer_pool() const { return *_buffer_pool; }
+
+  /**
+   * Sets the allocator for the temporary buffers this Communicator
+   * allocates internally, e.g. to put them in huge pages or in
+   * memory pre-registered for RDMA.  Packed range buffers are
+   * std::vector<buffer_type>, as Packing requires, so they still come
+   * from the heap.  Communicators split or duplicated from this one
+   * inherit the allocator.
+   */
+  void buffer_allocator(std::shared_ptr<BufferAllocator> allocator)
+  { _buffer_pool->allocator(std::move(allocator)); }
+
+  std::shared_ptr<BufferAllocator> buffer_allocator() const
+  { return _buffer_pool->allocator(); }
+
+  /**
+   * Sets the largest number of entries we pass to MPI as a plain
+   * count.  Larger sends, receives and broadcasts are described with
+   * derived datatypes, and larger vector gathers fall back to a
+   * broadcast or send per processor, so that they work even where
+   * MPI counts are only 32 bits.
+   *
+   * The default is the largest CountType, i.e. the limit is only
+   * reached without the MPI 4 large-count functions.  Lower values
+   * may help with MPI implementations which have trouble with
+   * messages near 2 GB.  Every processor must use the same setting.
+   */
+  void large_count_threshold (std::size_t max_count)
+  { timpi_assert_greater(max_count, 0); _large_count_threshold = max_count; }
+
+  std::size_t large_count_threshold() const
+  { return _large_count_threshold; }
+
   /**
    * Pause execution until all processors reach a certain point.
    */
@@ -648,6 +943,19 @@ public:
                              const MessageTag & tag,
                              bool & flag) const;
 
+  /**
+   * Non-Blocking matched probe for a packed range message.  Like
+   * packed_range_probe(), except that a message found is removed
+   * from the message queue and reserved for this caller, so no other
+   * receive can intercept it.  It must then be received by passing
+   * the returned Status to nonblocking_receive_packed_range().
+   */
+  template <typename T>
+  inline
+  Status packed_range_matched_probe (const unsigned int src_processor_id,
+                                     const MessageTag & tag,
+                                     bool & flag) const;
+
   /**
    * Blocking-send to one processor with data-defined type.
    */
@@ -708,6 +1016,33 @@ public:
              Request & req,
              const MessageTag & tag=no_tag) const;
 
+  /**
+   * Nonblocking-send to one processor with user-defined type, using
+   * the SendMode \p mode for this send rather than our send_mode().
+   */
+  template <typename T>
+  inline
+  void send (const unsigned int dest_processor_id,
+             const T & buf,
+             const DataType & type,
+             Request & req,
+             const MessageTag & tag,
+             const SendMode mode) const;
+
+  /**
+   * Nonblocking-send to one processor with user-defined packable
+   * type, using the SendMode \p mode for this send rather than our
+   * send_mode().
+   */
+  template <typename T>
+  inline
+  void send (const unsigned int dest_processor_id,
+             const T & buf,
+             const NotADataType & type,
+             Request & req,
+             const MessageTag & tag,
+             const SendMode mode) const;
+
   /**
    * Blocking-receive from one processor with data-defined type.
    */
@@ -756,6 +1091,55 @@ public:
                 Request & req,
                 const MessageTag & tag=any_tag) const;
 
+  /**
+   * Blocking-send of the entries of \p buf selected by \p subset,
+   * read directly from \p buf rather than packed first.
+   */
+  template <typename T, typename A>
+  inline
+  void send (const unsigned int dest_processor_id,
+             const std::vector<T,A> & buf,
+             const VectorSubset & subset,
+             const MessageTag & tag=no_tag) const;
+
+  /**
+   * Nonblocking-send of the entries of \p buf selected by \p subset,
+   * read directly from \p buf, which must not change until \p req
+   * is complete.
+   */
+  template <typename T, typename A>
+  inline
+  void send (const unsigned int dest_processor_id,
+             const std::vector<T,A> & buf,
+             const VectorSubset & subset,
+             Request & req,
+             const MessageTag & tag=no_tag) const;
+
+  /**
+   * Blocking-receive into the entries of \p buf selected by \p
+   * subset, written directly.  \p buf is not resized, so must already
+   * hold every selected entry; a shorter message only fills the
+   * first entries selected.
+   */
+  template <typename T, typename A>
+  inline
+  Status receive (const unsigned int src_processor_id,
+                  std::vector<T,A> & buf,
+                  const VectorSubset & subset,
+                  const MessageTag & tag=any_tag) const;
+
+  /**
+   * Nonblocking-receive into the entries of \p buf selected by \p
+   * subset, as above.
+   */
+  template <typename T, typename A>
+  inline
+  void receive (const unsigned int src_processor_id,
+                std::vector<T,A> & buf,
+                const VectorSubset & subset,
+                Request & req,
+                const MessageTag & tag=any_tag) const;
+
   /**
    * Nonblocking-receive from one processor with user-defined type.
    *
@@ -946,6 +1330,20 @@ public:
                                       Request & req,
                                       const MessageTag & tag=no_tag) const;
 
+  /**
+   * As above, but using the SendMode \p mode for this send rather
+   * than our send_mode().
+   */
+  template <typename Context, typename Iter>
+  inline
+  void nonblocking_send_packed_range (const unsigned int dest_processor_id,
+                                      const Context * context,
+                                      Iter range_begin,
+                                      const Iter range_end,
+                                      Request & req,
+                                      const MessageTag & tag,
+                                      const SendMode mode) const;
+
 
   /**
    * Similar to the above Nonblocking send_packed_range with a few important differences:
@@ -1455,6 +1853,17 @@ public:
                         const bool identical_sizes=false) const;
 #endif
 
+  /**
+   * Broadcast the entries of \p data selected by \p subset from the
+   * \p root_id processor, directly into the same entries of \p
+   * data everywhere else.  \p data is not resized, so must already
+   * hold every selected entry on every processor.
+   */
+  template <typename T, typename A>
+  inline void broadcast(std::vector<T,A> & data,
+                        const VectorSubset & subset,
+                        const unsigned int root_id=0) const;
+
   /**
    * Blocking-broadcast range-of-pointers to one processor.  This
    * function does not send the raw pointers, but rather constructs
@@ -0,0 +1,329 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_DISTRIBUTED_ARRAY_H
+#define TIMPI_DISTRIBUTED_ARRAY_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/ownership_map.h"
+#include "timpi/timpi_assert.h"
+#include "timpi/window.h"
+
+// C++ includes
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * A global array of \p T, with entries distributed over the
+ * processors of a Communicator according to an OwnershipMap, and
+ * readable and writable by global index from any processor without
+ * the owners' participation.
+ *
+ * Remote operations are batched: each get(), put() or accumulate()
+ * call issues a single one-sided operation per owning processor, no
+ * matter how many indices it names.  They only start that transfer;
+ * call flush() to complete this processor's operations (after which
+ * fetched values may be read and sent buffers reused), or the
+ * collective fence() to complete everyone's and make them visible in
+ * every local_data().
+ *
+ * The owner's entries are stored contiguously in local_data(), which
+ * may be read and written directly between fences.
+ *
+ * Construction and destruction are collective.
+ */
+template <typename T>
+class DistributedArray
+{
+public:
+  /**
+   * Creates an array of \p global_size entries, block-distributed
+   * over the processors of \p comm.
+   */
+  DistributedArray (const Communicator & comm,
+                    std::size_t global_size,
+                    const T & initial_value = T());
+
+  /**
+   * Creates an array distributed according to \p map, which must be
+   * identical on every processor.
+   */
+  DistributedArray (const Communicator & comm,
+                    std::shared_ptr<const OwnershipMap> map,
+                    const T & initial_value = T());
+
+  ~DistributedArray ();
+
+  DistributedArray (const DistributedArray &) = delete;
+  DistributedArray & operator= (const DistributedArray &) = delete;
+
+  std::size_t size () const { return _map->size(); }
+
+  const OwnershipMap & map () const { return *_map; }
+
+  const Communicator & comm () const { return _communicator; }
+
+  /**
+   * The entries owned by this processor, in local index order.
+   */
+  T * local_data () { return _local.data(); }
+
+  const T * local_data () const { return _local.data(); }
+
+  std::size_t local_size () const { return _local.size(); }
+
+  /**
+   * Starts fetching entries \p indices into \p values, which is
+   * resized to match; don't read or resize \p values before the next
+   * flush() or fence().
+   */
+  void get (const std::vector<std::size_t> & indices,
+            std::vector<T> & values) const;
+
+  /**
+   * Starts writing \p values to entries \p indices, which must not
+   * repeat an index; don't modify \p values before the next flush()
+   * or fence().  Writes to the same entry from different processors
+   * between fences are undefined; use accumulate() for those.
+   */
+  void put (const std::vector<std::size_t> & indices,
+            const std::vector<T> & values);
+
+  /**
+   * Starts combining \p values into entries \p indices via \p op,
+   * atomically with respect to every other accumulate() of those
+   * entries; don't modify \p values before the next flush() or
+   * fence().  \p indices must not repeat an index (MPI doesn't allow
+   * overlapping targets within one operation), so combine any values
+   * for the same entry before calling this.
+   */
+  void accumulate (const std::vector<std::size_t> & indices,
+                   const std::vector<T> & values,
+                   AccumulateOp op = AccumulateOp::SUM);
+
+  /**
+   * Completes every get(), put() and accumulate() started here.
+   * Their effects on other processors' local_data() are only
+   * guaranteed to be visible there after a fence().
+   */
+  void flush ();
+
+  /**
+   * Completes every processor's outstanding operations, and
+   * synchronizes them with every processor's local_data().  This is
+   * collective.
+   */
+  void fence ();
+
+private:
+  // Whether no entry appears twice in \p indices
+  static bool distinct (const std::vector<std::size_t> & indices);
+
+  // Calls \p op(pid, local_indices, positions) once for each
+  // processor owning any of \p indices
+  template <typename Op>
+  void for_each_owner (const std::vector<std::size_t> & indices,
+                       Op op) const;
+
+  const Communicator & _communicator;
+
+  std::shared_ptr<const OwnershipMap> _map;
+
+  std::vector<T> _local;
+
+  // Declared after _local, which it exposes; mutable because even
+  // remote reads go through a window handle
+  mutable Window<T> _window;
+};
+
+
+
+// ------------------------------------------------------------
+// DistributedArray inline member functions
+template <typename T>
+inline
+DistributedArray<T>::DistributedArray (const Communicator & comm,
+                                       std::size_t global_size,
+                                       const T & initial_value) :
+  DistributedArray
+    (comm, std::make_shared<BlockOwnershipMap>(comm.size(), global_size),
+     initial_value)
+{
+}
+
+
+
+template <typename T>
+inline
+DistributedArray<T>::DistributedArray (const Communicator & comm,
+                                       std::shared_ptr<const OwnershipMap> map,
+                                       const T & initial_value) :
+  _communicator(comm),
+  _map(std::move(map)),
+  _local(_map->n_local(comm.rank()), initial_value),
+  _window(comm, _local.data(), _local.size())
+{
+  // A single passive-target epoch for the array's lifetime, so that
+  // nobody has to wait on the owners for anything but fence()
+  _window.lock_all();
+}
+
+
+
+template <typename T>
+inline
+DistributedArray<T>::~DistributedArray ()
+{
+#ifdef TIMPI_HAVE_MPI
+  // Not bothering with return type; we can't throw in a destructor
+  MPI_Win_unlock_all(_window.get());
+#endif
+}
+
+
+
+template <typename T>
+inline
+bool DistributedArray<T>::distinct (const std::vector<std::size_t> & indices)
+{
+  std::vector<std::size_t> sorted(indices);
+  std::sort(sorted.begin(), sorted.end());
+  return std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end();
+}
+
+
+
+template <typename T>
+template <typename Op>
+inline
+void DistributedArray<T>::for_each_owner (const std::vector<std::size_t> & indices,
+                                          Op op) const
+{
+  const processor_id_type n_procs = _communicator.size();
+
+  std::vector<std::vector<std::size_t>> local_indices(n_procs),
+                                        positions(n_procs);
+
+  for (std::size_t i = 0, n = indices.size(); i != n; ++i)
+    {
+      const std::size_t index = indices[i];
+      timpi_assert_less(index, this->size());
+
+      const processor_id_type pid = _map->owner(index);
+      local_indices[pid].push_back(_map->local_index(index));
+      positions[pid].push_back(i);
+    }
+
+  for (processor_id_type p = 0; p != n_procs; ++p)
+    if (!local_indices[p].empty())
+      op(p, local_indices[p], positions[p]);
+}
+
+
+
+template <typename T>
+inline
+void DistributedArray<T>::get (const std::vector<std::size_t> & indices,
+                               std::vector<T> & values) const
+{
+  values.resize(indices.size());
+
+  this->for_each_owner
+    (indices,
+     [this, &values]
+     (processor_id_type p, const std::vector<std::size_t> & local_indices,
+      const std::vector<std::size_t> & positions)
+     {
+       _window.get(p, local_indices, values.data(), &positions);
+     });
+}
+
+
+
+template <typename T>
+inline
+void DistributedArray<T>::put (const std::vector<std::size_t> & indices,
+                               const std::vector<T> & values)
+{
+  timpi_assert_equal_to(indices.size(), values.size());
+  timpi_assert_msg(distinct(indices), "put() indices must not repeat");
+
+  this->for_each_owner
+    (indices,
+     [this, &values]
+     (processor_id_type p, const std::vector<std::size_t> & local_indices,
+      const std::vector<std::size_t> & positions)
+     {
+       _window.put(p, local_indices, values.data(), &positions);
+     });
+}
+
+
+
+template <typename T>
+inline
+void DistributedArray<T>::accumulate (const std::vector<std::size_t> & indices,
+                                      const std::vector<T> & values,
+                                      AccumulateOp op)
+{
+  timpi_assert_equal_to(indices.size(), values.size());
+  timpi_assert_msg(distinct(indices), "accumulate() indices must not repeat");
+
+  this->for_each_owner
+    (indices,
+     [this, &values, op]
+     (processor_id_type p, const std::vector<std::size_t> & local_indices,
+      const std::vector<std::size_t> & positions)
+     {
+       _window.accumulate(p, local_indices, values.data(), op, &positions);
+     });
+}
+
+
+
+template <typename T>
+inline
+void DistributedArray<T>::flush ()
+{
+  _window.flush_all();
+}
+
+
+
+template <typename T>
+inline
+void DistributedArray<T>::fence ()
+{
+  // Complete our operations everywhere, then make sure everyone else
+  // has too before anyone looks at their local data
+  _window.flush_all();
+  _window.sync();
+  _communicator.barrier();
+  _window.sync();
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_DISTRIBUTED_ARRAY_H
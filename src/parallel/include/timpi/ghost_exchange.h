@@ -0,0 +1,293 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_GHOST_EXCHANGE_H
+#define TIMPI_GHOST_EXCHANGE_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/indexed_type.h"
+#include "timpi/message_tag.h"
+#include "timpi/request.h"
+#include "timpi/standard_type.h"
+#include "timpi/timpi_assert.h"
+#include "timpi/timpi_call_mpi.h"
+
+// C++ includes
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * A reusable plan for updating ghost entries of a std::vector<T>
+ * from the processors which own them, when the same subsets are sent
+ * to the same neighbors every time.
+ *
+ * The constructor builds an indexed datatype for each neighbor's
+ * subset and a persistent MPI request for each send and receive, so
+ * every later update just starts and completes those requests:
+ * nothing is packed or allocated, and MPI reads and writes the
+ * vector in place.  Entries sent to ourselves are copied directly.
+ *
+ * The \p send_indices and \p receive_indices maps (e.g.
+ * std::map<processor_id_type, std::vector<std::size_t>>) give, for
+ * each neighbor, the indices of entries of \p data to send to it or
+ * overwrite with what it sends, in matching order; the lists on
+ * either end of each pair must have the same length.
+ *
+ * Every message of the plan uses \p tag, which must be the same on
+ * each neighbor and must not be used by any other traffic between
+ * neighbors while the plan exists; getting it from a collective
+ * Communicator::get_unique_tag() call is the easy way to ensure that.
+ *
+ * \p data must not be reallocated while the plan exists.
+ * Construction is not collective, but must be matched by a plan on
+ * each neighbor, and updates must be started in the same order
+ * everywhere.  \p T must have a fixed StandardType.
+ */
+template <typename T>
+class GhostExchange
+{
+public:
+  template <typename MapToVectors>
+  GhostExchange (const Communicator & comm,
+                 std::vector<T> & data,
+                 const MapToVectors & send_indices,
+                 const MapToVectors & receive_indices,
+                 const MessageTag & tag);
+
+  /**
+   * Completes any update in progress, then frees the requests.
+   */
+  ~GhostExchange ();
+
+  GhostExchange (const GhostExchange &) = delete;
+  GhostExchange & operator= (const GhostExchange &) = delete;
+
+  /**
+   * Starts an update of the ghost entries.  Until it is completed,
+   * the sent entries must not be modified and the received entries
+   * must not be accessed.
+   */
+  void start ();
+
+  /**
+   * Completes the update in progress.
+   */
+  void wait ();
+
+  /**
+   * \returns true, having completed it, if the update in progress is
+   * finished, false otherwise.
+   */
+  bool test ();
+
+  /**
+   * Does a complete update.
+   */
+  void exchange () { this->start(); this->wait(); }
+
+  /**
+   * \returns true if an update has been started and not completed.
+   */
+  bool active () const { return _active; }
+
+private:
+  std::vector<T> & _data;
+
+  // Where _data was when we built our requests
+  const T * _address;
+
+  // Keeps our tag reserved while our requests use it
+  MessageTag _tag;
+
+  // Derived types for each request, which must outlive them
+  std::vector<std::unique_ptr<IndexedType>> _types;
+
+  std::vector<request> _requests;
+
+  // Our entries to copy to our own ghosts
+  std::vector<std::size_t> _self_send, _self_receive;
+
+  bool _active;
+};
+
+
+
+// ------------------------------------------------------------
+// GhostExchange inline member functions
+template <typename T>
+template <typename MapToVectors>
+inline
+GhostExchange<T>::GhostExchange (const Communicator & comm,
+                                 std::vector<T> & data,
+                                 const MapToVectors & send_indices,
+                                 const MapToVectors & receive_indices,
+                                 const MessageTag & tag) :
+  _data(data),
+  _address(data.data()),
+  _tag(tag),
+  _active(false)
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be exchanged without packing");
+
+  // Our sends need a real tag to send with
+  timpi_assert_not_equal_to(tag.value(), any_tag.value());
+
+  const processor_id_type rank = comm.rank();
+
+#ifdef TIMPI_HAVE_MPI
+  StandardType<T> type(data.data());
+
+  // Receives first, so they are started first
+  for (int pass = 0; pass != 2; ++pass)
+    {
+      const bool receiving = (pass == 0);
+      for (const auto & pair : receiving ? receive_indices : send_indices)
+        {
+          const processor_id_type pid = pair.first;
+          const auto & indices = pair.second;
+
+          timpi_assert_less(pid, comm.size());
+
+          if (pid == rank || indices.empty())
+            continue;
+
+#ifndef NDEBUG
+          for (std::size_t i : indices)
+            timpi_assert_less(i, data.size());
+#endif
+
+          _types.emplace_back(new IndexedType(type, indices));
+
+          request req;
+          if (receiving)
+            timpi_call_mpi
+              (MPI_Recv_init(data.data(), 1, *_types.back(), int(pid),
+                             _tag.value(), comm.get(), &req));
+          else
+            timpi_call_mpi
+              (MPI_Send_init(data.data(), 1, *_types.back(), int(pid),
+                             _tag.value(), comm.get(), &req));
+          _requests.push_back(req);
+        }
+    }
+#endif
+
+  // Self-exchanges don't need to go through MPI at all
+  auto self_send = send_indices.find(rank);
+  if (self_send != send_indices.end())
+    _self_send.assign(self_send->second.begin(), self_send->second.end());
+
+  auto self_receive = receive_indices.find(rank);
+  if (self_receive != receive_indices.end())
+    _self_receive.assign(self_receive->second.begin(),
+                         self_receive->second.end());
+
+  timpi_assert_equal_to(_self_send.size(), _self_receive.size());
+
+#ifndef TIMPI_HAVE_MPI
+  // Without MPI we have no other neighbors
+  timpi_assert_equal_to(send_indices.size(),
+                        std::size_t(self_send != send_indices.end()));
+  timpi_assert_equal_to(receive_indices.size(),
+                        std::size_t(self_receive != receive_indices.end()));
+#endif
+}
+
+
+
+template <typename T>
+inline
+GhostExchange<T>::~GhostExchange ()
+{
+#ifdef TIMPI_HAVE_MPI
+  // Not bothering with return types; we can't throw in a destructor
+  if (_active)
+    MPI_Waitall(int(_requests.size()), _requests.data(),
+                MPI_STATUSES_IGNORE);
+
+  for (request & req : _requests)
+    MPI_Request_free(&req);
+#endif
+}
+
+
+
+template <typename T>
+inline
+void GhostExchange<T>::start ()
+{
+  timpi_assert(!_active);
+  timpi_assert(_data.data() == _address);
+
+  if (!_requests.empty())
+    timpi_call_mpi
+      (MPI_Startall(cast_int<int>(_requests.size()), _requests.data()));
+
+  for (std::size_t i = 0, n = _self_send.size(); i != n; ++i)
+    _data[_self_receive[i]] = _data[_self_send[i]];
+
+  _active = true;
+}
+
+
+
+template <typename T>
+inline
+void GhostExchange<T>::wait ()
+{
+  timpi_assert(_active);
+
+  if (!_requests.empty())
+    timpi_call_mpi
+      (MPI_Waitall(cast_int<int>(_requests.size()), _requests.data(),
+                   MPI_STATUSES_IGNORE));
+
+  _active = false;
+}
+
+
+
+template <typename T>
+inline
+bool GhostExchange<T>::test ()
+{
+  timpi_assert(_active);
+
+  int done = 1;
+
+  if (!_requests.empty())
+    timpi_call_mpi
+      (MPI_Testall(cast_int<int>(_requests.size()), _requests.data(),
+                   &done, MPI_STATUSES_IGNORE));
+
+  if (done)
+    _active = false;
+
+  return done;
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_GHOST_EXCHANGE_H
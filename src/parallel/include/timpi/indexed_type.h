@@ -0,0 +1,120 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_INDEXED_TYPE_H
+#define TIMPI_INDEXED_TYPE_H
+
+// TIMPI includes
+#include "timpi/data_type.h"
+#include "timpi/timpi_assert.h"
+#include "timpi/timpi_call_mpi.h"
+
+// C++ includes
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * A derived datatype describing the entries at \p indices of an
+ * array whose entries have datatype \p base, so that one entry of
+ * this type at the start of the array covers exactly those entries,
+ * in that order, without copying them anywhere first.
+ *
+ * The type is committed on construction and freed on destruction;
+ * MPI lets operations which already use it run to completion.
+ */
+class IndexedType : public DataType
+{
+public:
+  template <typename Index>
+  IndexedType (const data_type & base,
+               const std::vector<Index> & indices);
+
+  /**
+   * Describes \p count entries, \p stride entries apart.
+   */
+  IndexedType (const data_type & base,
+               std::size_t count,
+               std::size_t stride);
+
+  ~IndexedType ();
+
+  IndexedType (const IndexedType &) = delete;
+  IndexedType & operator= (const IndexedType &) = delete;
+};
+
+
+
+// ------------------------------------------------------------
+// IndexedType inline member functions
+template <typename Index>
+inline
+IndexedType::IndexedType (const data_type & base,
+                          const std::vector<Index> & indices)
+{
+#ifdef TIMPI_HAVE_MPI
+  MPI_Aint lb, extent;
+  timpi_call_mpi
+    (MPI_Type_get_extent(base, &lb, &extent));
+
+  std::vector<MPI_Aint> displacements(indices.size());
+  for (std::size_t i = 0, n = indices.size(); i != n; ++i)
+    displacements[i] = MPI_Aint(indices[i]) * extent;
+
+  timpi_call_mpi
+    (MPI_Type_create_hindexed_block
+      (cast_int<int>(indices.size()), 1, displacements.data(), base,
+       &_datatype));
+
+  this->commit();
+#else
+  ignore(base, indices);
+#endif
+}
+
+
+
+inline
+IndexedType::IndexedType (const data_type & base,
+                          std::size_t count,
+                          std::size_t stride)
+{
+  timpi_call_mpi
+    (MPI_Type_vector(cast_int<int>(count), 1, cast_int<int>(stride),
+                     base, &_datatype));
+  ignore(base, count, stride); // ifndef TIMPI_HAVE_MPI
+
+  this->commit();
+}
+
+
+
+inline
+IndexedType::~IndexedType ()
+{
+#ifdef TIMPI_HAVE_MPI
+  // Not bothering with return type; we can't throw in a destructor
+  MPI_Type_free(&_datatype);
+#endif
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_INDEXED_TYPE_H
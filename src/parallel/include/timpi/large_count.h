@@ -0,0 +1,84 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_LARGE_COUNT_H
+#define TIMPI_LARGE_COUNT_H
+
+// TIMPI includes
+#include "timpi/data_type.h"
+#include "timpi/status.h"
+
+// C++ includes
+#include <cstddef>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * A count and datatype which MPI can take in place of \p count
+ * entries of \p type, even if \p count is more than \p max_count or
+ * more than a CountType can hold.
+ *
+ * Counts no larger than \p max_count are passed through unchanged.
+ * Larger counts are described by a single entry of a derived
+ * datatype: a contiguous run of \p max_count-entry chunks (or
+ * smaller, if \p max_count is too large for an int), followed by the
+ * remainder.  Its signature is the same as that of the
+ * original entries, so the other side of the communication can
+ * describe its data either way.
+ *
+ * The derived datatype is freed when this object is destroyed; MPI
+ * lets nonblocking operations which already use it run to completion.
+ */
+class LargeCount
+{
+public:
+  LargeCount (std::size_t count,
+              const data_type & type,
+              std::size_t max_count);
+
+  ~LargeCount ();
+
+  LargeCount (const LargeCount &) = delete;
+  LargeCount & operator= (const LargeCount &) = delete;
+
+  /**
+   * The count to give MPI
+   */
+  CountType count () const { return _count; }
+
+  /**
+   * The datatype to give MPI
+   */
+  const data_type & type () const { return _type; }
+
+  /**
+   * Whether we had to build a derived datatype
+   */
+  bool chunked () const { return _chunked; }
+
+private:
+  CountType _count;
+  data_type _type;
+  bool _chunked;
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_LARGE_COUNT_H
@@ -0,0 +1,118 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_OWNERSHIP_MAP_H
+#define TIMPI_OWNERSHIP_MAP_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+
+// C++ includes
+#include <cstddef>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * Maps each global index of a distributed array to the processor
+ * which owns that entry, and to its index in that processor's local
+ * storage.  Every processor must hold an identical map.
+ *
+ * Subclass this for custom distributions; BlockOwnershipMap handles
+ * the usual contiguous one.
+ */
+class OwnershipMap
+{
+public:
+  virtual ~OwnershipMap () = default;
+
+  /**
+   * The global number of entries.
+   */
+  virtual std::size_t size () const = 0;
+
+  /**
+   * The number of entries owned by processor \p pid.
+   */
+  virtual std::size_t n_local (processor_id_type pid) const = 0;
+
+  /**
+   * The processor owning entry \p i.
+   */
+  virtual processor_id_type owner (std::size_t i) const = 0;
+
+  /**
+   * The index of entry \p i in its owner's local storage.
+   */
+  virtual std::size_t local_index (std::size_t i) const = 0;
+};
+
+
+
+/**
+ * Distributes entries in contiguous blocks, with processor p owning
+ * the entries after those of processor p-1.
+ */
+class BlockOwnershipMap : public OwnershipMap
+{
+public:
+  /**
+   * Splits \p size entries as evenly as possible over \p n_procs
+   * processors, with any extras on the lowest ranks.
+   */
+  BlockOwnershipMap (processor_id_type n_procs,
+                     std::size_t size);
+
+  /**
+   * Gives processor p local_sizes[p] entries.
+   */
+  BlockOwnershipMap (const std::vector<std::size_t> & local_sizes);
+
+  /**
+   * Gives each processor of \p comm its \p n_local entries; this
+   * constructor is collective.
+   */
+  BlockOwnershipMap (const Communicator & comm,
+                     std::size_t n_local);
+
+  virtual std::size_t size () const override;
+
+  virtual std::size_t n_local (processor_id_type pid) const override;
+
+  virtual processor_id_type owner (std::size_t i) const override;
+
+  virtual std::size_t local_index (std::size_t i) const override;
+
+  /**
+   * The global index of the first entry owned by processor \p pid.
+   */
+  std::size_t first_index (processor_id_type pid) const;
+
+private:
+  void set_offsets (const std::vector<std::size_t> & local_sizes);
+
+  // _offsets[p] is the first index owned by processor p;
+  // _offsets.back() is the global size
+  std::vector<std::size_t> _offsets;
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_OWNERSHIP_MAP_H
@@ -0,0 +1,199 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_PACKED_COMPRESSION_H
+#define TIMPI_PACKED_COMPRESSION_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/timpi_assert.h"
+
+// C++ includes
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace TIMPI
+{
+
+namespace detail
+{
+
+/**
+ * Compresses \p n_bytes bytes from \p in, which hold words of \p
+ * word_size bytes each, with \p codec, appending the result to \p
+ * out.  The result may be larger than the input.
+ */
+void compress_bytes (Communicator::PackedCompression codec,
+                     const char * in,
+                     std::size_t n_bytes,
+                     std::size_t word_size,
+                     std::vector<char> & out);
+
+/**
+ * Decompresses \p n_in bytes from \p in, written by compress_bytes()
+ * with the same \p codec and \p word_size, into exactly \p n_out
+ * bytes at \p out.
+ */
+void decompress_bytes (Communicator::PackedCompression codec,
+                       const char * in,
+                       std::size_t n_in,
+                       std::size_t word_size,
+                       char * out,
+                       std::size_t n_out);
+
+/**
+ * Each compressed buffer is a frame: this header, padded to a whole
+ * number of buffer entries, then the payload.  Frames are
+ * self-delimiting, so the concatenated buffers from a gather can be
+ * decompressed in one pass.
+ */
+struct PackedFrameHeader
+{
+  std::uint32_t codec;
+  std::uint32_t raw_entries;
+  std::uint32_t payload_entries;
+};
+
+template <typename buffer_t>
+constexpr std::size_t packed_frame_header_entries()
+{
+  return (sizeof(PackedFrameHeader) + sizeof(buffer_t) - 1) /
+    sizeof(buffer_t);
+}
+
+} // namespace detail
+
+
+
+/**
+ * Replaces a packed range \p buffer with a compressed frame, using \p
+ * codec if the buffer holds at least \p threshold_bytes and the codec
+ * actually shrinks it, or storing it raw otherwise.  Does nothing
+ * with NO_COMPRESSION, or with an empty buffer, so that "nothing to
+ * send" keeps meaning the same thing.
+ */
+template <typename buffer_t>
+inline void
+compress_packed_buffer (std::vector<buffer_t> & buffer,
+                        Communicator::PackedCompression codec,
+                        std::size_t threshold_bytes)
+{
+  static_assert(std::is_trivially_copyable<buffer_t>::value,
+                "Packed buffers must be trivially copyable to compress");
+
+  if (codec == Communicator::NO_COMPRESSION || buffer.empty())
+    return;
+
+  const std::size_t header_entries =
+    detail::packed_frame_header_entries<buffer_t>();
+  const std::size_t raw_bytes = buffer.size() * sizeof(buffer_t);
+
+  std::vector<char> payload;
+  if (raw_bytes >= threshold_bytes)
+    detail::compress_bytes(codec,
+                           reinterpret_cast<const char *>(buffer.data()),
+                           raw_bytes, sizeof(buffer_t), payload);
+
+  const std::size_t payload_entries =
+    (payload.size() + sizeof(buffer_t) - 1) / sizeof(buffer_t);
+
+  detail::PackedFrameHeader header;
+  header.raw_entries = cast_int<std::uint32_t>(buffer.size());
+
+  // Too small to bother with, or incompressible: store it raw
+  if (payload.empty() || payload_entries >= buffer.size())
+    {
+      header.codec = Communicator::NO_COMPRESSION;
+      header.payload_entries = header.raw_entries;
+      buffer.insert(buffer.begin(), header_entries, buffer_t());
+      std::memcpy(buffer.data(), &header, sizeof(header));
+      return;
+    }
+
+  header.codec = codec;
+  header.payload_entries = cast_int<std::uint32_t>(payload_entries);
+
+  std::vector<buffer_t> framed(header_entries + payload_entries);
+  std::memcpy(framed.data(), &header, sizeof(header));
+  std::memcpy(framed.data() + header_entries, payload.data(),
+              payload.size());
+  buffer.swap(framed);
+}
+
+
+
+/**
+ * Replaces a \p buffer of one or more frames written by
+ * compress_packed_buffer() with the concatenation of the original
+ * buffers.  Does nothing if \p codec is NO_COMPRESSION, i.e. if the
+ * sender would not have compressed.
+ */
+template <typename buffer_t>
+inline void
+decompress_packed_buffer (std::vector<buffer_t> & buffer,
+                          Communicator::PackedCompression codec)
+{
+  if (codec == Communicator::NO_COMPRESSION || buffer.empty())
+    return;
+
+  const std::size_t header_entries =
+    detail::packed_frame_header_entries<buffer_t>();
+
+  std::vector<buffer_t> raw;
+
+  for (std::size_t pos = 0; pos != buffer.size();)
+    {
+      timpi_assert_less_equal(pos + header_entries, buffer.size());
+
+      detail::PackedFrameHeader header;
+      std::memcpy(&header, buffer.data() + pos, sizeof(header));
+      pos += header_entries;
+
+      timpi_assert_less_equal(pos + header.payload_entries, buffer.size());
+
+      const std::size_t raw_begin = raw.size();
+      raw.resize(raw_begin + header.raw_entries);
+
+      if (header.codec == Communicator::NO_COMPRESSION)
+        {
+          timpi_assert_equal_to(header.payload_entries, header.raw_entries);
+          std::copy(buffer.begin() + pos,
+                    buffer.begin() + pos + header.payload_entries,
+                    raw.begin() + raw_begin);
+        }
+      else
+        detail::decompress_bytes
+          (static_cast<Communicator::PackedCompression>(header.codec),
+           reinterpret_cast<const char *>(buffer.data() + pos),
+           header.payload_entries * sizeof(buffer_t), sizeof(buffer_t),
+           reinterpret_cast<char *>(raw.data() + raw_begin),
+           header.raw_entries * sizeof(buffer_t));
+
+      pos += header.payload_entries;
+    }
+
+  buffer.swap(raw);
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_PACKED_COMPRESSION_H
@@ -28,7 +28,9 @@
 #include <climits>     // CHAR_BIT
 #include <cstring>     // memcpy
 #include <iterator>
+#include <limits>
 #include <type_traits> // is_same
+#include <vector>
 
 // C++17 gives us "if constexpr", which nvc++ really seems to need in
 // order to determine that warnings shouldn't be emitted inside a
@@ -1012,6 +1014,9 @@ public:
 namespace TIMPI {
 
 using libMesh::Parallel::Packing;
+using libMesh::Parallel::get_packed_len;
+using libMesh::Parallel::get_packed_len_entries;
+using libMesh::Parallel::put_packed_len;
 
 // ------------------------------------------------------------
 // Packing member functions, global functions
@@ -1123,6 +1128,164 @@ inline OutputIter unpack_range (const std::vector<buffertype> & buffer,
   return out_iter;
 }
 
+
+
+/**
+ * Helper function for indexed range packing.  Like pack_range, this
+ * appends as many objects as fit in about \p approx_buffer_size
+ * entries to \p buffer, and returns an iterator to the first object
+ * not packed.  The objects are appended as a chunk which starts with
+ * their count and the end offset of each, so that a PackedRangeIndex
+ * can find any object in the chunk in O(1) rather than by walking
+ * through every object before it.
+ */
+template <typename Context, typename buffertype, typename Iter>
+inline Iter pack_range_indexed (const Context * context,
+                                Iter range_begin,
+                                const Iter range_end,
+                                std::vector<buffertype> & buffer,
+                                std::size_t approx_buffer_size)
+{
+  typedef typename std::iterator_traits<Iter>::value_type T;
+
+  // Find the end offset of each object we'll pack, stopping early if
+  // the buffer would be too large.
+  std::vector<std::size_t> object_ends;
+  std::size_t data_size = 0;
+  Iter range_stop = range_begin;
+  for (; range_stop != range_end && data_size < approx_buffer_size;
+       ++range_stop)
+    {
+      data_size += Packing<T>::packable_size(*range_stop, context);
+      object_ends.push_back(data_size);
+    }
+
+  constexpr int len_entries = get_packed_len_entries<buffertype>();
+  buffer.reserve(buffer.size() + (object_ends.size() + 1) * len_entries +
+                 data_size);
+
+  // Write the index
+  timpi_assert_less_equal
+    (data_size, std::size_t(std::numeric_limits<int>::max()));
+  put_packed_len<buffertype>(object_ends.size(), std::back_inserter(buffer));
+  for (const std::size_t end : object_ends)
+    put_packed_len<buffertype>(end, std::back_inserter(buffer));
+
+  // Pack the objects into the buffer
+#ifndef NDEBUG
+  const std::size_t data_start = buffer.size();
+  std::size_t i = 0;
+#endif
+  for (; range_begin != range_stop; ++range_begin)
+    {
+      Packing<T>::pack
+        (*range_begin, std::back_inserter(buffer), context);
+
+#ifndef NDEBUG
+      timpi_assert_equal_to (buffer.size(), data_start + object_ends[i++]);
+#endif
+    }
+
+  return range_stop;
+}
+
+
+
+/**
+ * Random access to the objects in a chunk written by
+ * pack_range_indexed.  Locating an object costs O(1), so objects can
+ * be unpacked in any order, in parallel, or not at all.
+ */
+template <typename buffertype>
+class PackedRangeIndex
+{
+public:
+  typedef typename std::vector<buffertype>::const_iterator iterator;
+
+  /**
+   * Indexes the chunk which starts at \p chunk_begin.
+   */
+  explicit PackedRangeIndex (iterator chunk_begin) :
+    _n_objects(get_packed_len<buffertype>(chunk_begin)),
+    _object_ends(chunk_begin + len_entries),
+    _data_begin(_object_ends + _n_objects * len_entries)
+  {}
+
+  /**
+   * The number of objects in the chunk.
+   */
+  std::size_t size () const { return _n_objects; }
+
+  /**
+   * The start of the packed object \p i.
+   */
+  iterator object_begin (std::size_t i) const
+  {
+    timpi_assert_less(i, _n_objects);
+    return _data_begin + (i ? object_end_offset(i-1) : 0);
+  }
+
+  /**
+   * The end of the chunk, where any next chunk begins.
+   */
+  iterator chunk_end () const
+  {
+    return _data_begin + (_n_objects ? object_end_offset(_n_objects-1) : 0);
+  }
+
+  /**
+   * Unpacks object \p i.
+   */
+  template <typename T, typename Context>
+  T unpack (std::size_t i, Context * context) const
+  {
+    return Packing<T>::unpack(object_begin(i), context);
+  }
+
+private:
+  static constexpr int len_entries = get_packed_len_entries<buffertype>();
+
+  std::size_t object_end_offset (std::size_t i) const
+  {
+    return get_packed_len<buffertype>(_object_ends + i * len_entries);
+  }
+
+  std::size_t _n_objects;
+  iterator _object_ends;
+  iterator _data_begin;
+};
+
+
+
+/**
+ * Helper function for indexed range unpacking: unpacks every object
+ * in every chunk of \p buffer, which must have been filled by
+ * pack_range_indexed.
+ */
+template <typename Context, typename buffertype,
+          typename OutputIter, typename T>
+inline OutputIter unpack_range_indexed (const std::vector<buffertype> & buffer,
+                                        Context * context,
+                                        OutputIter out_iter,
+                                        const T * /* output_type */)
+{
+  typename std::vector<buffertype>::const_iterator
+    next_chunk_start = buffer.begin();
+
+  while (next_chunk_start < buffer.end())
+    {
+      const PackedRangeIndex<buffertype> index(next_chunk_start);
+      for (std::size_t i = 0; i != index.size(); ++i)
+        *out_iter++ = index.template unpack<T>(i, context);
+      next_chunk_start = index.chunk_end();
+    }
+
+  // We should have used up the exact amount of data in the buffer
+  timpi_assert (next_chunk_start == buffer.end());
+
+  return out_iter;
+}
+
 } // namespace TIMPI
 
 #endif // TIMPI_PACKING_H
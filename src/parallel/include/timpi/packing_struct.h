@@ -0,0 +1,379 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_PACKING_STRUCT_H
+#define TIMPI_PACKING_STRUCT_H
+
+// TIMPI includes
+#include "timpi/packing.h"
+#include "timpi/standard_type_struct.h"
+
+// C++ includes
+#include <array>
+#include <cstring>
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Defines a Packing<Type> specialization for a user class with
+ * variable-size members, given the names of the data members to
+ * communicate:
+ *
+ * \verbatim
+ * struct Face { unsigned int id; double normal[3]; std::string name; std::vector<unsigned int> nodes; };
+ *
+ * TIMPI_PACKING_STRUCT(Face, id, normal, name, nodes)
+ * \endverbatim
+ *
+ * Members with fixed StandardTypes (and C arrays or std::arrays of
+ * them) are copied together into one contiguous block; every other
+ * member is packed after that block, in the order listed, with its
+ * own Packing.  The whole encoding starts with its total length, so
+ * packed_size() costs O(1).  When packing into the back of a buffer
+ * vector, as pack_range() does, that length is filled in after the
+ * members are packed rather than by walking them beforehand.
+ *
+ * Type must be default constructible.  The macro also defines a
+ * StandardType<Type> which is NotADataType, so that communication of
+ * Type objects dispatches to packed ranges automatically.  It must be
+ * used at global scope, with a fully qualified type name, and
+ * supports up to 16 members.
+ */
+#define TIMPI_PACKING_STRUCT(Type, ...)                                   \
+  namespace TIMPI {                                                     \
+  template <>                                                           \
+  class StandardType<Type> : public NotADataType                        \
+  {                                                                     \
+  public:                                                               \
+    StandardType(const Type * = nullptr) {}                             \
+  };                                                                    \
+  }                                                                     \
+                                                                        \
+  namespace libMesh {                                                   \
+  namespace Parallel {                                                  \
+  template <>                                                           \
+  struct PackedStructFields<Type>                                       \
+  {                                                                     \
+    static auto fields()                                                \
+    {                                                                   \
+      return std::make_tuple                                            \
+        (TIMPI_STRUCT_MEMBER_POINTERS(Type, __VA_ARGS__));              \
+    }                                                                   \
+  };                                                                    \
+                                                                        \
+  template <>                                                           \
+  class Packing<Type> : public PackingStruct<Type> {};                  \
+  }                                                                     \
+  }
+
+
+namespace libMesh
+{
+
+namespace Parallel
+{
+
+/**
+ * Specialized by TIMPI_PACKING_STRUCT, with a static fields()
+ * function returning a tuple of pointers to the members of T which
+ * are to be packed.
+ */
+template <typename T>
+struct PackedStructFields;
+
+
+// Whether a struct member can be copied as raw bytes
+template <typename MemberPointer>
+struct PackedStructMemberIsFixed
+{
+  static const bool value = TIMPI::StandardType
+    <TIMPI::detail::struct_member_element_t<MemberPointer>>::is_fixed_type;
+};
+
+
+// The number of bytes in the fixed-size block of a packed struct
+template <typename Fields>
+struct PackedStructFixedBytes;
+
+template <typename... MemberPointers>
+struct PackedStructFixedBytes<std::tuple<MemberPointers...>>
+{
+  static constexpr std::size_t value()
+  {
+    const std::size_t sizes[] =
+      {0, (PackedStructMemberIsFixed<MemberPointers>::value ?
+           sizeof(typename TIMPI::detail::StructMember<MemberPointers>::type) :
+           0)...};
+    std::size_t total = 0;
+    for (const std::size_t size : sizes)
+      total += size;
+    return total;
+  }
+};
+
+
+/**
+ * The Packing implementation for TIMPI_PACKING_STRUCT.  An object is
+ * encoded as its total length, then a block holding every fixed-size
+ * member, then each variable-size member's own encoding.
+ */
+template <typename T>
+class PackingStruct
+{
+public:
+  typedef unsigned int buffer_type;
+
+  template <typename OutputIter, typename Context>
+  static void pack(const T & object, OutputIter data_out, const Context * context);
+
+  template <typename Context>
+  static void pack(const T & object,
+                   std::back_insert_iterator<std::vector<buffer_type>> data_out,
+                   const Context * context);
+
+  template <typename Context>
+  static unsigned int packable_size(const T & object, const Context * context);
+
+  template <typename BufferIter>
+  static unsigned int packed_size(BufferIter iter);
+
+  template <typename BufferIter, typename Context>
+  static T unpack(BufferIter in, Context * ctx);
+
+private:
+  typedef decltype(PackedStructFields<T>::fields()) fields_type;
+
+  static constexpr std::size_t fixed_bytes()
+  { return PackedStructFixedBytes<fields_type>::value(); }
+
+  static constexpr unsigned int fixed_entries()
+  { return (fixed_bytes() + sizeof(buffer_type) - 1) / sizeof(buffer_type); }
+
+  template <typename Functor>
+  static void for_each_member(const Functor & f)
+  {
+    TIMPI::detail::for_each_struct_field
+      (PackedStructFields<T>::fields(), f,
+       std::make_index_sequence<std::tuple_size<fields_type>::value>());
+  }
+
+  template <typename MemberPointer>
+  using is_fixed = std::integral_constant
+    <bool, PackedStructMemberIsFixed<MemberPointer>::value>;
+
+  // The fixed-size block and the variable-size members, without the
+  // leading length
+  template <typename OutputIter, typename Context>
+  static void pack_members(const T & object, OutputIter data_out, const Context * ctx);
+
+  // Lets us find the buffer a back_insert_iterator appends to
+  struct BackInserterBuffer : std::back_insert_iterator<std::vector<buffer_type>>
+  {
+    static std::vector<buffer_type> &
+    get(const std::back_insert_iterator<std::vector<buffer_type>> & it)
+    { return *(it.*(&BackInserterBuffer::container)); }
+  };
+
+  template <typename F>
+  static void check_buffer_type()
+  {
+    static_assert(std::is_same<typename Packing<F>::buffer_type, buffer_type>::value,
+                  "TIMPI_PACKING_STRUCT members must pack into unsigned int buffers");
+  }
+
+  // Fixed-size members are handled by the block; the rest by their
+  // own Packing
+  template <typename F, typename Context>
+  static unsigned int member_packable_size(const F &, const Context *, std::true_type)
+  { return 0; }
+
+  template <typename F, typename Context>
+  static unsigned int member_packable_size(const F & member, const Context * ctx, std::false_type)
+  {
+    check_buffer_type<F>();
+    return Packing<F>::packable_size(member, ctx);
+  }
+
+  template <typename F, typename OutputIter, typename Context>
+  static void pack_member(const F &, OutputIter, const Context *, std::true_type) {}
+
+  template <typename F, typename OutputIter, typename Context>
+  static void pack_member(const F & member, OutputIter data_out, const Context * ctx, std::false_type)
+  {
+    Packing<F>::pack(member, data_out, ctx);
+  }
+
+  template <typename F, typename BufferIter, typename Context>
+  static void unpack_member(F &, BufferIter &, Context *, std::true_type) {}
+
+  template <typename F, typename BufferIter, typename Context>
+  static void unpack_member(F & member, BufferIter & in, Context * ctx, std::false_type)
+  {
+    member = Packing<F>::unpack(in, ctx);
+    in += Packing<F>::packed_size(in);
+  }
+};
+
+
+
+template <typename T>
+template <typename Context>
+unsigned int
+PackingStruct<T>::packable_size(const T & object, const Context * ctx)
+{
+  unsigned int size = get_packed_len_entries<buffer_type>() + fixed_entries();
+
+  for_each_member
+    ([&object, ctx, &size](auto member)
+     {
+       size += member_packable_size(object.*member, ctx,
+                                    is_fixed<decltype(member)>());
+     });
+
+  return size;
+}
+
+
+
+template <typename T>
+template <typename BufferIter>
+unsigned int
+PackingStruct<T>::packed_size(BufferIter iter)
+{
+  // We recorded the size in the first buffer entries
+  return get_packed_len<buffer_type>(iter);
+}
+
+
+
+template <typename T>
+template <typename OutputIter, typename Context>
+void
+PackingStruct<T>::pack(const T & object, OutputIter data_out, const Context * ctx)
+{
+  put_packed_len<buffer_type>(packable_size(object, ctx), data_out);
+
+  pack_members(object, data_out, ctx);
+}
+
+
+
+template <typename T>
+template <typename Context>
+void
+PackingStruct<T>::pack(const T & object,
+                       std::back_insert_iterator<std::vector<buffer_type>> data_out,
+                       const Context * ctx)
+{
+  std::vector<buffer_type> & buffer = BackInserterBuffer::get(data_out);
+  const std::size_t start = buffer.size();
+
+  // Reserve room for our length, and fill it in once we know it
+  put_packed_len<buffer_type>(0, data_out);
+
+  pack_members(object, data_out, ctx);
+
+  const std::size_t len = buffer.size() - start;
+  timpi_assert_equal_to(len, packable_size(object, ctx));
+  put_packed_len<buffer_type>(TIMPI::cast_int<unsigned int>(len), buffer.begin() + start);
+}
+
+
+
+template <typename T>
+template <typename OutputIter, typename Context>
+void
+PackingStruct<T>::pack_members(const T & object, OutputIter data_out, const Context * ctx)
+{
+  // Copy the fixed-size members into one zero-padded block
+  std::array<buffer_type, fixed_entries()> block {};
+  char * block_bytes = reinterpret_cast<char *>(block.data());
+  std::size_t offset = 0;
+  for_each_member
+    ([&object, block_bytes, &offset](auto member)
+     {
+       typedef typename TIMPI::detail::StructMember<decltype(member)>::type F;
+       if (is_fixed<decltype(member)>::value)
+         {
+           std::memcpy(block_bytes + offset,
+                       reinterpret_cast<const char *>(&(object.*member)),
+                       sizeof(F));
+           offset += sizeof(F);
+         }
+     });
+  timpi_assert_equal_to(offset, fixed_bytes());
+
+  for (const buffer_type entry : block)
+    *data_out++ = entry;
+
+  for_each_member
+    ([&object, &data_out, ctx](auto member)
+     {
+       pack_member(object.*member, data_out, ctx,
+                   is_fixed<decltype(member)>());
+     });
+}
+
+
+
+template <typename T>
+template <typename BufferIter, typename Context>
+T
+PackingStruct<T>::unpack(BufferIter in, Context * ctx)
+{
+  T object;
+
+  in += get_packed_len_entries<buffer_type>();
+
+  if (fixed_entries())
+    {
+      const char * block_bytes = reinterpret_cast<const char *>(&(*in));
+      std::size_t offset = 0;
+      for_each_member
+        ([&object, block_bytes, &offset](auto member)
+         {
+           typedef typename TIMPI::detail::StructMember<decltype(member)>::type F;
+           if (is_fixed<decltype(member)>::value)
+             {
+               std::memcpy(reinterpret_cast<char *>(&(object.*member)),
+                           block_bytes + offset, sizeof(F));
+               offset += sizeof(F);
+             }
+         });
+      in += fixed_entries();
+    }
+
+  for_each_member
+    ([&object, &in, ctx](auto member)
+     {
+       unpack_member(object.*member, in, ctx,
+                     is_fixed<decltype(member)>());
+     });
+
+  return object;
+}
+
+} // namespace Parallel
+
+} // namespace libMesh
+
+#endif // TIMPI_PACKING_STRUCT_H
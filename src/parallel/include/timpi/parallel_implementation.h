@@ -26,19 +26,25 @@
 #include "timpi/timpi_call_mpi.h"
 #include "timpi/message_tag.h"
 #include "timpi/op_function.h"
+#include "timpi/packed_compression.h"
 #include "timpi/packing.h"
 #include "timpi/timpi_assert.h"
 #include "timpi/post_wait_copy_buffer.h"
+#include "timpi/post_wait_decompress_buffer.h"
 #include "timpi/post_wait_delete_buffer.h"
 #include "timpi/post_wait_dereference_shared_ptr.h"
 #include "timpi/post_wait_dereference_tag.h"
 #include "timpi/post_wait_free_buffer.h"
+#include "timpi/post_wait_release_buffer.h"
 #include "timpi/post_wait_unpack_buffer.h"
 #include "timpi/post_wait_unpack_nested_buffer.h"
 #include "timpi/post_wait_work.h"
 #include "timpi/request.h"
+#include "timpi/sorted_integer_encoding.h"
 #include "timpi/status.h"
 #include "timpi/standard_type.h"
+#include "timpi/sync_timers.h"
+#include "timpi/timpi_profiler.h"
 
 #ifndef TIMPI_HAVE_MPI
 #include "timpi/serial_implementation.h"
@@ -49,10 +55,6 @@
 # include <boost/multiprecision/float128.hpp>
 #endif
 
-// Disable libMesh logging until we decide how to port it best
-// #include "libmesh/libmesh_logging.h"
-#define TIMPI_LOG_SCOPE(f,c)
-
 // C++ includes
 #include <complex>
 #include <cstddef>
@@ -226,6 +228,8 @@ dataplusint_type_acquire()
 #  define TIMPI_UNPACK MPI_Unpack_c
 #  define TIMPI_RECV MPI_Recv_c
 #  define TIMPI_IRECV MPI_Irecv_c
+#  define TIMPI_IMRECV MPI_Imrecv_c
+#  define TIMPI_MRECV MPI_Mrecv_c
 #  define TIMPI_SENDRECV MPI_Sendrecv_c
 #  define TIMPI_ALLGATHERV MPI_Allgatherv_c
 #  define TIMPI_ALLGATHER MPI_Allgather_c
@@ -249,6 +253,8 @@ dataplusint_type_acquire()
 #  define TIMPI_UNPACK MPI_Unpack
 #  define TIMPI_RECV MPI_Recv
 #  define TIMPI_IRECV MPI_Irecv
+#  define TIMPI_IMRECV MPI_Imrecv
+#  define TIMPI_MRECV MPI_Mrecv
 #  define TIMPI_SENDRECV MPI_Sendrecv
 #  define TIMPI_ALLGATHERV MPI_Allgatherv
 #  define TIMPI_ALLGATHER MPI_Allgather
@@ -310,6 +316,17 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   timpi_assert_less(dest_processor_id, this->size());
 
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  if (this->send_mode() == BUFFERED)
+    {
+      this->buffered_send(dataptr, buf.size() * sizeof(T),
+                          cast_int<CountType>(buf.size()),
+                          StandardType<T>(dataptr), dest_processor_id,
+                          tag);
+      return;
+    }
+
   timpi_call_mpi
     (((this->send_mode() == SYNCHRONOUS) ?
       TIMPI_SSEND : TIMPI_SEND)
@@ -332,12 +349,20 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   timpi_assert_less(dest_processor_id, this->size());
 
-  timpi_call_mpi
-    (((this->send_mode() == SYNCHRONOUS) ?
-      TIMPI_ISSEND : TIMPI_ISEND)
-        (dataptr, cast_int<CountType>(buf.size()),
-         StandardType<T>(dataptr), dest_processor_id, tag.value(),
-         this->get(), req.get()));
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  if (this->send_mode() == BUFFERED)
+    this->buffered_send(dataptr, buf.size() * sizeof(T),
+                        cast_int<CountType>(buf.size()),
+                        StandardType<T>(dataptr), dest_processor_id,
+                        tag, req.get());
+  else
+    timpi_call_mpi
+      (((this->send_mode() == SYNCHRONOUS) ?
+        TIMPI_ISSEND : TIMPI_ISEND)
+          (dataptr, cast_int<CountType>(buf.size()),
+           StandardType<T>(dataptr), dest_processor_id, tag.value(),
+           this->get(), req.get()));
 
   // The MessageTag should stay registered for the Request lifetime
   req.add_post_wait_work
@@ -357,6 +382,15 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   timpi_assert_less(dest_processor_id, this->size());
 
+  TIMPI_LOG_BYTES(sizeof(T));
+
+  if (this->send_mode() == BUFFERED)
+    {
+      this->buffered_send(dataptr, sizeof(T), 1, StandardType<T>(dataptr),
+                          dest_processor_id, tag);
+      return;
+    }
+
   timpi_call_mpi
     (((this->send_mode() == SYNCHRONOUS) ?
       TIMPI_SSEND : TIMPI_SEND)
@@ -378,11 +412,17 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   timpi_assert_less(dest_processor_id, this->size());
 
-  timpi_call_mpi
-    (((this->send_mode() == SYNCHRONOUS) ?
-      TIMPI_ISSEND : TIMPI_ISEND)
-        (dataptr, 1, StandardType<T>(dataptr), dest_processor_id,
-         tag.value(), this->get(), req.get()));
+  TIMPI_LOG_BYTES(sizeof(T));
+
+  if (this->send_mode() == BUFFERED)
+    this->buffered_send(dataptr, sizeof(T), 1, StandardType<T>(dataptr),
+                        dest_processor_id, tag, req.get());
+  else
+    timpi_call_mpi
+      (((this->send_mode() == SYNCHRONOUS) ?
+        TIMPI_ISSEND : TIMPI_ISEND)
+          (dataptr, 1, StandardType<T>(dataptr), dest_processor_id,
+           tag.value(), this->get(), req.get()));
 
   // The MessageTag should stay registered for the Request lifetime
   req.add_post_wait_work
@@ -497,11 +537,23 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 {
   TIMPI_LOG_SCOPE("send()", "Parallel");
 
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  const LargeCount count(buf.size(), type, this->large_count_threshold());
+
+  if (this->send_mode() == BUFFERED)
+    {
+      this->buffered_send(buf.data(), buf.size() * sizeof(T),
+                          count.count(), count.type(),
+                          dest_processor_id, tag);
+      return;
+    }
+
   timpi_call_mpi
     (((this->send_mode() == SYNCHRONOUS) ?
       TIMPI_SSEND : TIMPI_SEND)
         (buf.empty() ? nullptr : const_cast<T*>(buf.data()),
-         cast_int<CountType>(buf.size()), type, dest_processor_id,
+         count.count(), count.type(), dest_processor_id,
          tag.value(), this->get()));
 }
 
@@ -513,17 +565,39 @@ inline void Communicator::send (const unsigned int dest_processor_id,
                                 const DataType & type,
                                 Request & req,
                                 const MessageTag & tag) const
+{
+  this->send(dest_processor_id, buf, type, req, tag, this->send_mode());
+}
+
+
+
+template <typename T, typename A, typename std::enable_if<std::is_base_of<DataType, StandardType<T>>::value, int>::type>
+inline void Communicator::send (const unsigned int dest_processor_id,
+                                const std::vector<T,A> & buf,
+                                const DataType & type,
+                                Request & req,
+                                const MessageTag & tag,
+                                const SendMode mode) const
 {
   TIMPI_LOG_SCOPE("send()", "Parallel");
 
   timpi_assert_less(dest_processor_id, this->size());
 
-  timpi_call_mpi
-    (((this->send_mode() == SYNCHRONOUS) ?
-      TIMPI_ISSEND : TIMPI_ISEND)
-        (buf.empty() ? nullptr : const_cast<T*>(buf.data()),
-         cast_int<CountType>(buf.size()), type, dest_processor_id,
-         tag.value(), this->get(), req.get()));
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  const LargeCount count(buf.size(), type, this->large_count_threshold());
+
+  if (mode == BUFFERED)
+    this->buffered_send(buf.data(), buf.size() * sizeof(T),
+                        count.count(), count.type(),
+                        dest_processor_id, tag, req.get());
+  else
+    timpi_call_mpi
+      (((mode == SYNCHRONOUS) ?
+        TIMPI_ISSEND : TIMPI_ISEND)
+          (buf.empty() ? nullptr : const_cast<T*>(buf.data()),
+           count.count(), count.type(), dest_processor_id,
+           tag.value(), this->get(), req.get()));
 
   // The MessageTag should stay registered for the Request lifetime
   req.add_post_wait_work
@@ -533,9 +607,22 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 template <typename T, typename A, typename std::enable_if<Has_buffer_type<Packing<T>>::value, int>::type>
 inline void Communicator::send (const unsigned int dest_processor_id,
                                 const std::vector<T,A> & buf,
-                                const NotADataType &,
+                                const NotADataType & type,
                                 Request & req,
                                 const MessageTag & tag) const
+{
+  this->send(dest_processor_id, buf, type, req, tag, this->send_mode());
+}
+
+
+
+template <typename T, typename A, typename std::enable_if<Has_buffer_type<Packing<T>>::value, int>::type>
+inline void Communicator::send (const unsigned int dest_processor_id,
+                                const std::vector<T,A> & buf,
+                                const NotADataType &,
+                                Request & req,
+                                const MessageTag & tag,
+                                const SendMode mode) const
 {
   TIMPI_LOG_SCOPE("send()", "Parallel");
 
@@ -546,7 +633,92 @@ inline void Communicator::send (const unsigned int dest_processor_id,
                                       buf.begin(),
                                       buf.end(),
                                       req,
-                                      tag);
+                                      tag,
+                                      mode);
+}
+
+
+
+template <typename T, typename A>
+inline void Communicator::send (const unsigned int dest_processor_id,
+                                const std::vector<T,A> & buf,
+                                const VectorSubset & subset,
+                                const MessageTag & tag) const
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be sent from a VectorSubset");
+
+  TIMPI_LOG_SCOPE("send()", "Parallel");
+
+  timpi_assert_less(dest_processor_id, this->size());
+  timpi_assert_greater_equal(buf.size(), subset.required_size());
+
+  // A buffered send copies anyway, so just copy what we need
+  if (this->send_mode() == BUFFERED)
+    {
+      std::vector<T> selected(subset.size());
+      for (std::size_t i = 0, n = subset.size(); i != n; ++i)
+        selected[i] = buf[subset[i]];
+      this->send(dest_processor_id, selected, tag);
+      return;
+    }
+
+  TIMPI_LOG_BYTES(subset.size() * sizeof(T));
+
+  const T * data_ptr = subset.size() ? buf.data() + subset.offset() : nullptr;
+  StandardType<T> base(data_ptr);
+  const std::shared_ptr<const DataType> type = subset.datatype(base);
+
+  timpi_call_mpi
+    (((this->send_mode() == SYNCHRONOUS) ?
+      MPI_Ssend : MPI_Send)
+        (const_cast<T*>(data_ptr), 1, *type, dest_processor_id,
+         tag.value(), this->get()));
+}
+
+
+
+template <typename T, typename A>
+inline void Communicator::send (const unsigned int dest_processor_id,
+                                const std::vector<T,A> & buf,
+                                const VectorSubset & subset,
+                                Request & req,
+                                const MessageTag & tag) const
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be sent from a VectorSubset");
+
+  TIMPI_LOG_SCOPE("send()", "Parallel");
+
+  timpi_assert_less(dest_processor_id, this->size());
+  timpi_assert_greater_equal(buf.size(), subset.required_size());
+
+  // A buffered send copies anyway, so just copy what we need
+  if (this->send_mode() == BUFFERED)
+    {
+      std::vector<T> selected(subset.size());
+      for (std::size_t i = 0, n = subset.size(); i != n; ++i)
+        selected[i] = buf[subset[i]];
+      this->send(dest_processor_id, selected, req, tag);
+      return;
+    }
+
+  TIMPI_LOG_BYTES(subset.size() * sizeof(T));
+
+  // MPI lets us free the type once the send is started
+  const T * data_ptr = subset.size() ? buf.data() + subset.offset() : nullptr;
+  StandardType<T> base(data_ptr);
+  const std::shared_ptr<const DataType> type = subset.datatype(base);
+
+  timpi_call_mpi
+    (((this->send_mode() == SYNCHRONOUS) ?
+      MPI_Issend : MPI_Isend)
+        (const_cast<T*>(data_ptr), 1, *type, dest_processor_id,
+         tag.value(), this->get(), req.get()));
+
+  // The MessageTag should stay registered for the Request lifetime
+  req.add_post_wait_work
+    (new PostWaitDereferenceTag(tag));
 }
 
 
@@ -597,6 +769,19 @@ inline void Communicator::send (const unsigned int dest_processor_id,
                                 const DataType & type,
                                 Request & req,
                                 const MessageTag & tag) const
+{
+  this->send(dest_processor_id, send_vecs, type, req, tag, this->send_mode());
+}
+
+
+
+template <typename T, typename A1, typename A2>
+inline void Communicator::send (const unsigned int dest_processor_id,
+                                const std::vector<std::vector<T,A1>,A2> & send_vecs,
+                                const DataType & type,
+                                Request & req,
+                                const MessageTag & tag,
+                                const SendMode mode) const
 {
   // figure out how many bytes we need to pack all the data
   const CountType sendsize =
@@ -604,7 +789,7 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   // temporary buffer - this will be sized in bytes
   // and manipulated with MPI_Pack
-  std::vector<char> * sendbuf = new std::vector<char>(sendsize);
+  PooledBuffer<char> sendbuf(*_buffer_pool, sendsize);
 
   // Pack the send buffer
   CountType pos=0;
@@ -637,10 +822,10 @@ inline void Communicator::send (const unsigned int dest_processor_id,
 
   timpi_assert_equal_to (pos, sendsize);
 
-  req.add_post_wait_work
-    (new PostWaitDeleteBuffer<std::vector<char>> (sendbuf));
+  this->send (dest_processor_id, *sendbuf, MPI_PACKED, req, tag, mode);
 
-  this->send (dest_processor_id, *sendbuf, MPI_PACKED, req, tag);
+  req.add_post_wait_work
+    (new PostWaitReleaseBuffer<char> (_buffer_pool, sendbuf.release()));
 }
 
 
@@ -665,11 +850,16 @@ inline void Communicator::send_packed_range (const unsigned int dest_processor_i
   std::size_t used_buffer_size = 0;
 #endif
 
+  // One buffer serves for every chunk
+  typedef typename Packing<T>::buffer_type buffer_t;
+  PooledBuffer<buffer_t, std::allocator<buffer_t>> buffer_buf(*_buffer_pool, 0);
+  std::vector<buffer_t> & buffer = *buffer_buf;
+
   while (range_begin != range_end)
     {
       timpi_assert_greater (std::distance(range_begin, range_end), 0);
 
-      std::vector<typename Packing<T>::buffer_type> buffer;
+      buffer.clear();
 
       const Iter next_range_begin = pack_range
         (context, range_begin, range_end, buffer, approx_buffer_size);
@@ -682,10 +872,14 @@ inline void Communicator::send_packed_range (const unsigned int dest_processor_i
       used_buffer_size += buffer.size();
 #endif
 
+      compress_packed_buffer(buffer, this->packed_compression(),
+                             this->packed_compression_threshold());
+
       // Blocking send of the buffer
       this->send(dest_processor_id, buffer, tag);
     }
 
+
 #ifdef DEBUG
   timpi_assert_equal_to(used_buffer_size, total_buffer_size);
 #endif
@@ -733,7 +927,7 @@ inline void Communicator::send_packed_range (const unsigned int dest_processor_i
     {
       timpi_assert_greater (std::distance(range_begin, range_end), 0);
 
-      std::vector<buffer_t> * buffer = new std::vector<buffer_t>();
+      PooledBuffer<buffer_t, std::allocator<buffer_t>> buffer(*_buffer_pool, 0);
 
       const Iter next_range_begin = pack_range
         (context, range_begin, range_end, *buffer, approx_buffer_size);
@@ -746,18 +940,21 @@ inline void Communicator::send_packed_range (const unsigned int dest_processor_i
       used_buffer_size += buffer->size();
 #endif
 
+      compress_packed_buffer(*buffer, this->packed_compression(),
+                             this->packed_compression_threshold());
+
       Request next_intermediate_req;
 
       Request * my_req = (range_begin == range_end) ? &req : &next_intermediate_req;
 
-      // Make the Request::wait() handle deleting the buffer
-      my_req->add_post_wait_work
-        (new PostWaitDeleteBuffer<std::vector<buffer_t>>
-         (buffer));
-
       // Non-blocking send of the buffer
       this->send(dest_processor_id, *buffer, *my_req, tag);
 
+      // Make the Request::wait() handle releasing the buffer
+      my_req->add_post_wait_work
+        (new PostWaitReleaseBuffer<buffer_t, std::allocator<buffer_t>>
+         (_buffer_pool, buffer.release()));
+
       if (range_begin != range_end)
         req.add_prior_request(*my_req);
     }
@@ -776,6 +973,22 @@ inline void Communicator::nonblocking_send_packed_range (const unsigned int dest
                                                          const Iter range_end,
                                                          Request & req,
                                                          const MessageTag & tag) const
+{
+  this->nonblocking_send_packed_range(dest_processor_id, context,
+                                      range_begin, range_end, req, tag,
+                                      this->send_mode());
+}
+
+
+
+template <typename Context, typename Iter>
+inline void Communicator::nonblocking_send_packed_range (const unsigned int dest_processor_id,
+                                                         const Context * context,
+                                                         Iter range_begin,
+                                                         const Iter range_end,
+                                                         Request & req,
+                                                         const MessageTag & tag,
+                                                         const SendMode mode) const
 {
   // Allocate a buffer on the heap so we don't have to free it until
   // after the Request::wait()
@@ -784,28 +997,35 @@ inline void Communicator::nonblocking_send_packed_range (const unsigned int dest
 
   if (range_begin != range_end)
     {
-      std::vector<buffer_t> * buffer = new std::vector<buffer_t>();
-
-      range_begin =
-        pack_range(context,
-                   range_begin,
-                   range_end,
-                   *buffer,
-                   // MPI-2/3 can only use signed integers for size,
-                   // and with this API we need to fit a non-blocking
-                   // send into one buffer
-                   std::numeric_limits<CountType>::max());
+      PooledBuffer<buffer_t, std::allocator<buffer_t>> buffer(*_buffer_pool, 0);
 
-      if (range_begin != range_end)
-        timpi_error_msg("Non-blocking packed range sends cannot exceed " << std::numeric_limits<CountType>::max() << "in size");
+      {
+        SyncTimers::PhaseTimer packing(SyncTimers::PACK);
+        range_begin =
+          pack_range(context,
+                     range_begin,
+                     range_end,
+                     *buffer,
+                     // With this API we need to fit a non-blocking
+                     // send into one buffer; send() takes care of
+                     // any buffer too big for an MPI count
+                     std::numeric_limits<std::size_t>::max());
+
+        compress_packed_buffer(*buffer, this->packed_compression(),
+                               this->packed_compression_threshold());
+      }
 
-      // Make the Request::wait() handle deleting the buffer
-      req.add_post_wait_work
-        (new PostWaitDeleteBuffer<std::vector<buffer_t>>
-         (buffer));
+      timpi_assert(range_begin == range_end);
 
       // Non-blocking send of the buffer
-      this->send(dest_processor_id, *buffer, req, tag);
+      this->send(dest_processor_id, *buffer,
+                 StandardType<buffer_t>(buffer->data()), req, tag,
+                 mode);
+
+      // Make the Request::wait() handle releasing the buffer
+      req.add_post_wait_work
+        (new PostWaitReleaseBuffer<buffer_t, std::allocator<buffer_t>>
+         (_buffer_pool, buffer.release()));
     }
 }
 
@@ -861,9 +1081,9 @@ inline Status Communicator::receive (const unsigned int src_processor_id,
 {
   TIMPI_LOG_SCOPE("receive()", "Parallel");
 
-  // Get the status of the message, explicitly provide the
-  // datatype so we can later query the size
-  Status stat(this->probe(src_processor_id, tag), StandardType<T>(&buf));
+  // We already know the size of a single value, so there's no need
+  // to probe (and match the message twice) before receiving it.
+  Status stat((StandardType<T>(&buf)));
 
   timpi_assert(src_processor_id < this->size() ||
                   src_processor_id == any_source);
@@ -872,6 +1092,8 @@ inline Status Communicator::receive (const unsigned int src_processor_id,
     (TIMPI_RECV (&buf, 1, StandardType<T>(&buf), src_processor_id,
                  tag.value(), this->get(), stat.get()));
 
+  TIMPI_LOG_BYTES(sizeof(T));
+
   return stat;
 }
 
@@ -888,6 +1110,8 @@ inline void Communicator::receive (const unsigned int src_processor_id,
   timpi_assert(src_processor_id < this->size() ||
                   src_processor_id == any_source);
 
+  TIMPI_LOG_BYTES(sizeof(T));
+
   timpi_call_mpi
     (TIMPI_IRECV (&buf, 1, StandardType<T>(&buf), src_processor_id,
                   tag.value(), this->get(), req.get()));
@@ -1016,25 +1240,31 @@ inline Status Communicator::receive (const unsigned int src_processor_id,
 {
   TIMPI_LOG_SCOPE("receive()", "Parallel");
 
+  timpi_assert(src_processor_id < this->size() ||
+                  src_processor_id == any_source);
+
   // Get the status of the message, explicitly provide the
-  // datatype so we can later query the size
-  Status stat(this->probe(src_processor_id, tag), type);
+  // datatype so we can later query the size.  We use a matched
+  // probe, so that even if src_processor_id or tag is "any" the
+  // message we receive is the same message we just probed.
+  Status stat(type);
+
+  timpi_call_mpi
+    (MPI_Mprobe (int(src_processor_id), tag.value(), this->get(),
+                 stat.matched_message(), stat.get()));
 
-  buf.resize(stat.size());
+  buf.resize(stat.large_size());
 
-  timpi_assert(src_processor_id < this->size() ||
-                  src_processor_id == any_source);
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  const LargeCount count(buf.size(), type, this->large_count_threshold());
 
-  // Use stat.source() and stat.tag() in the receive - if
-  // src_processor_id is or tag is "any" then we want to be sure we
-  // try to receive the same message we just probed.
   timpi_call_mpi
-    (TIMPI_RECV (buf.empty() ? nullptr : buf.data(),
-                 cast_int<CountType>(buf.size()), type, stat.source(),
-                 stat.tag(), this->get(), stat.get()));
+    (TIMPI_MRECV (buf.empty() ? nullptr : buf.data(),
+                  count.count(), count.type(),
+                  stat.matched_message(), stat.get()));
 
-  timpi_assert_equal_to (cast_int<std::size_t>(stat.size()),
-                         buf.size());
+  timpi_assert_equal_to (stat.large_size(), buf.size());
 
   return stat;
 }
@@ -1051,7 +1281,7 @@ Status Communicator::receive (const unsigned int src_processor_id,
   bool flag = false;
   Status stat;
   while (!flag)
-    stat = this->packed_range_probe<T>(src_processor_id, tag, flag);
+    stat = this->packed_range_matched_probe<T>(src_processor_id, tag, flag);
 
   Request req;
   this->nonblocking_receive_packed_range(src_processor_id, (void *)(nullptr),
@@ -1073,7 +1303,7 @@ Status Communicator::receive (const unsigned int src_processor_id,
   bool flag = false;
   Status stat;
   while (!flag)
-    stat = this->packed_range_probe<T>(src_processor_id, tag, flag);
+    stat = this->packed_range_matched_probe<T>(src_processor_id, tag, flag);
 
   Request req;
   this->nonblocking_receive_packed_range(src_processor_id, (void *)(nullptr),
@@ -1097,9 +1327,13 @@ inline void Communicator::receive (const unsigned int src_processor_id,
   timpi_assert(src_processor_id < this->size() ||
                   src_processor_id == any_source);
 
+  TIMPI_LOG_BYTES(buf.size() * sizeof(T));
+
+  const LargeCount count(buf.size(), type, this->large_count_threshold());
+
   timpi_call_mpi
     (TIMPI_IRECV(buf.empty() ? nullptr : buf.data(),
-                 cast_int<CountType>(buf.size()), type, src_processor_id,
+                 count.count(), count.type(), src_processor_id,
                  tag.value(), this->get(), req.get()));
 
   // The MessageTag should stay registered for the Request lifetime
@@ -1109,6 +1343,74 @@ inline void Communicator::receive (const unsigned int src_processor_id,
 
 
 
+template <typename T, typename A>
+inline Status Communicator::receive (const unsigned int src_processor_id,
+                                     std::vector<T,A> & buf,
+                                     const VectorSubset & subset,
+                                     const MessageTag & tag) const
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be received into a VectorSubset");
+
+  TIMPI_LOG_SCOPE("receive()", "Parallel");
+
+  timpi_assert(src_processor_id < this->size() ||
+                  src_processor_id == any_source);
+  timpi_assert_greater_equal(buf.size(), subset.required_size());
+
+  TIMPI_LOG_BYTES(subset.size() * sizeof(T));
+
+  T * data_ptr = subset.size() ? buf.data() + subset.offset() : nullptr;
+  StandardType<T> base(data_ptr);
+  const std::shared_ptr<const DataType> type = subset.datatype(base);
+
+  // Explicitly provide the entry datatype, so we can later query the
+  // number of entries received
+  Status stat(base);
+
+  timpi_call_mpi
+    (MPI_Recv (data_ptr, 1, *type, src_processor_id, tag.value(),
+               this->get(), stat.get()));
+
+  return stat;
+}
+
+
+
+template <typename T, typename A>
+inline void Communicator::receive (const unsigned int src_processor_id,
+                                   std::vector<T,A> & buf,
+                                   const VectorSubset & subset,
+                                   Request & req,
+                                   const MessageTag & tag) const
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be received into a VectorSubset");
+
+  TIMPI_LOG_SCOPE("receive()", "Parallel");
+
+  timpi_assert(src_processor_id < this->size() ||
+                  src_processor_id == any_source);
+  timpi_assert_greater_equal(buf.size(), subset.required_size());
+
+  TIMPI_LOG_BYTES(subset.size() * sizeof(T));
+
+  // MPI lets us free the type once the receive is started
+  T * data_ptr = subset.size() ? buf.data() + subset.offset() : nullptr;
+  StandardType<T> base(data_ptr);
+  const std::shared_ptr<const DataType> type = subset.datatype(base);
+
+  timpi_call_mpi
+    (MPI_Irecv (data_ptr, 1, *type, src_processor_id, tag.value(),
+                this->get(), req.get()));
+
+  // The MessageTag should stay registered for the Request lifetime
+  req.add_post_wait_work
+    (new PostWaitDereferenceTag(tag));
+}
+
+
+
 template <typename T, typename A1, typename A2>
 inline Status Communicator::receive (const unsigned int src_processor_id,
                                      std::vector<std::vector<T,A1>,A2> & buf,
@@ -1143,7 +1445,8 @@ inline Status Communicator::receive (const unsigned int src_processor_id,
 {
   // temporary buffer - this will be sized in bytes
   // and manipulated with MPI_Unpack
-  std::vector<char> recvbuf;
+  PooledBuffer<char> recvbuf_buf(*_buffer_pool, 0);
+  InternalBuffer<char> & recvbuf = *recvbuf_buf;
 
   Status stat = this->receive (src_processor_id, recvbuf, MPI_PACKED, tag);
 
@@ -1179,6 +1482,7 @@ inline Status Communicator::receive (const unsigned int src_processor_id,
                         subvec_size, type, this->get()));
     }
 
+
   return stat;
 }
 
@@ -1198,19 +1502,20 @@ inline void Communicator::receive (const unsigned int src_processor_id,
 
   // temporary buffer - this will be sized in bytes
   // and manipulated with MPI_Unpack
-  std::vector<char> * recvbuf = new std::vector<char>(sendsize);
+  PooledBuffer<char> recvbuf(*_buffer_pool, sendsize);
 
   // Get ready to receive the temporary buffer
   this->receive (src_processor_id, *recvbuf, MPI_PACKED, req, tag);
 
   // When we wait on the receive, we'll unpack the temporary buffer
   req.add_post_wait_work
-    (new PostWaitUnpackNestedBuffer<std::vector<std::vector<T,A1>,A2>>
+    (new PostWaitUnpackNestedBuffer<std::vector<std::vector<T,A1>,A2>,
+                                    InternalBuffer<char>>
        (*recvbuf, buf, type, *this));
 
-  // And then we'll free the temporary buffer
+  // And then we'll release the temporary buffer
   req.add_post_wait_work
-    (new PostWaitDeleteBuffer<std::vector<char>>(recvbuf));
+    (new PostWaitReleaseBuffer<char>(_buffer_pool, recvbuf.release()));
 
   // The MessageTag should stay registered for the Request lifetime
   req.add_post_wait_work
@@ -1242,15 +1547,20 @@ inline void Communicator::receive_packed_range (const unsigned int src_processor
   std::unique_ptr<OutputIter> next_out_iter =
     std::make_unique<OutputIter>(out_iter);
 
+  // One buffer serves for every chunk
+  PooledBuffer<buffer_t, std::allocator<buffer_t>> buffer_buf(*_buffer_pool, 0);
+  std::vector<buffer_t> & buffer = *buffer_buf;
+
   while (received_buffer_size < total_buffer_size)
     {
-      std::vector<buffer_t> buffer;
       this->receive(stat.source(), buffer, MessageTag(stat.tag()));
+      decompress_packed_buffer(buffer, this->packed_compression());
       received_buffer_size += buffer.size();
       auto return_out_iter = unpack_range
         (buffer, context, *next_out_iter, output_type);
       next_out_iter = std::make_unique<OutputIter>(return_out_iter);
     }
+
 }
 
 
@@ -1297,16 +1607,38 @@ inline void Communicator::nonblocking_receive_packed_range (const unsigned int s
   // buffer_t.
   // Allocate a buffer on the heap so we don't have to free it until
   // after the Request::wait()
-  std::vector<buffer_t> * buffer = new std::vector<buffer_t>(stat.size());
-  this->receive(src_processor_id, *buffer, req, tag);
+  PooledBuffer<buffer_t, std::allocator<buffer_t>> buffer
+    (*_buffer_pool, stat.large_size());
+
+  // If we have a matched message from packed_range_matched_probe(), receive
+  // exactly that message
+  if (stat.has_matched_message())
+    {
+      StandardType<buffer_t> type(buffer->data());
+      const LargeCount count(buffer->size(), type,
+                             this->large_count_threshold());
+
+      timpi_call_mpi
+        (TIMPI_IMRECV(buffer->data(), count.count(), count.type(),
+                      stat.matched_message(), req.get()));
+    }
+  else
+    this->receive(src_processor_id, *buffer, req, tag);
+
+  // Make the Request::wait() handle decompressing and then unpacking
+  // the buffer
+  if (this->packed_compression() != NO_COMPRESSION)
+    req.add_post_wait_work
+      (new PostWaitDecompressBuffer<std::vector<buffer_t>>
+       (*buffer, this->packed_compression()));
 
-  // Make the Request::wait() handle unpacking the buffer
   req.add_post_wait_work
     (new PostWaitUnpackBuffer<std::vector<buffer_t>, Context, OutputIter, T>(*buffer, context, out));
 
-  // Make the Request::wait() then handle deleting the buffer
+  // Make the Request::wait() then handle releasing the buffer
   req.add_post_wait_work
-    (new PostWaitDeleteBuffer<std::vector<buffer_t>>(buffer));
+    (new PostWaitReleaseBuffer<buffer_t, std::allocator<buffer_t>>
+         (_buffer_pool, buffer.release()));
 
   // The MessageTag should stay registered for the Request lifetime
   req.add_post_wait_work
@@ -1597,18 +1929,23 @@ inline void Communicator::nonblocking_send_packed_range (const unsigned int dest
       else
         buffer->clear();
 
-      range_begin =
-        pack_range(context,
-                   range_begin,
-                   range_end,
-                   *buffer,
-                   // MPI-2/3 can only use signed integers for size,
-                   // and with this API we need to fit a non-blocking
-                   // send into one buffer
-                   std::numeric_limits<CountType>::max());
+      {
+        SyncTimers::PhaseTimer packing(SyncTimers::PACK);
+        range_begin =
+          pack_range(context,
+                     range_begin,
+                     range_end,
+                     *buffer,
+                     // With this API we need to fit a non-blocking
+                     // send into one buffer; send() takes care of
+                     // any buffer too big for an MPI count
+                     std::numeric_limits<std::size_t>::max());
+
+        compress_packed_buffer(*buffer, this->packed_compression(),
+                               this->packed_compression_threshold());
+      }
 
-      if (range_begin != range_end)
-        timpi_error_msg("Non-blocking packed range sends cannot exceed " << std::numeric_limits<CountType>::max() << "in size");
+      timpi_assert(range_begin == range_end);
 
       // Make it dereference the shared pointer (possibly freeing the buffer)
       req.add_post_wait_work
@@ -1895,6 +2232,17 @@ template <typename T, typename C, typename A>
 inline void Communicator::broadcast (std::set<T,C,A> & data,
                                      const unsigned int root_id,
                                      const bool identical_sizes) const
+{
+  this->set_broadcast(data, root_id, identical_sizes);
+}
+
+
+
+template <typename Set,
+          typename std::enable_if<!HasSortedIntegerKeys<Set>::value, int>::type>
+inline void Communicator::set_broadcast (Set & data,
+                                         const unsigned int root_id,
+                                         const bool identical_sizes) const
 {
   if (this->size() == 1)
     {
@@ -1908,7 +2256,7 @@ inline void Communicator::broadcast (std::set<T,C,A> & data,
 
   TIMPI_LOG_SCOPE("broadcast()", "Parallel");
 
-  std::vector<T> vecdata;
+  std::vector<typename Set::value_type> vecdata;
   if (this->rank() == root_id)
     vecdata.assign(data.begin(), data.end());
 
@@ -1920,7 +2268,7 @@ inline void Communicator::broadcast (std::set<T,C,A> & data,
   if (this->rank() != root_id)
     vecdata.resize(vecsize);
 
-  this->broadcast(vecdata, root_id, StandardType<T>::is_fixed_type);
+  this->broadcast(vecdata, root_id, StandardType<typename Set::value_type>::is_fixed_type);
   if (this->rank() != root_id)
     {
       data.clear();
@@ -1929,6 +2277,46 @@ inline void Communicator::broadcast (std::set<T,C,A> & data,
 }
 
 
+
+template <typename Set,
+          typename std::enable_if<HasSortedIntegerKeys<Set>::value, int>::type>
+inline void Communicator::set_broadcast (Set & data,
+                                         const unsigned int root_id,
+                                         const bool identical_sizes) const
+{
+  if (this->size() == 1)
+    {
+      timpi_assert (!this->rank());
+      timpi_assert (!root_id);
+      return;
+    }
+
+  timpi_assert_less (root_id, this->size());
+  timpi_assert (this->verify(identical_sizes));
+  timpi_ignore(identical_sizes); // Encoded sizes differ regardless
+
+  TIMPI_LOG_SCOPE("broadcast()", "Parallel");
+
+  std::vector<unsigned char> buffer;
+  if (this->rank() == root_id)
+    encode_sorted_integers<typename Set::key_type>
+      (data.begin(), data.end(), data.size(), buffer);
+
+  std::size_t buffer_size = buffer.size();
+  this->broadcast(buffer_size, root_id);
+  if (this->rank() != root_id)
+    buffer.resize(buffer_size);
+
+  this->broadcast(buffer, root_id, true);
+  if (this->rank() != root_id)
+    {
+      data.clear();
+      decode_sorted_integers<typename Set::key_type>
+        (buffer, std::inserter(data, data.end()));
+    }
+}
+
+
 template <typename Context, typename OutputIter, typename T>
 inline void Communicator::nonblocking_receive_packed_range (const unsigned int src_processor_id,
                                                             Context * context,
@@ -1949,10 +2337,34 @@ inline void Communicator::nonblocking_receive_packed_range (const unsigned int s
   // buffer_t.
   // Allocate a buffer on the heap so we don't have to free it until
   // after the Request::wait()
-  buffer->resize(stat.size());
-  this->receive(src_processor_id, *buffer, req, tag);
+  buffer->resize(stat.large_size());
+
+  // If we have a matched message from packed_range_matched_probe(), receive
+  // exactly that message
+  if (stat.has_matched_message())
+    {
+      StandardType<typename Packing<T>::buffer_type> type(buffer->data());
+      const LargeCount count(buffer->size(), type,
+                             this->large_count_threshold());
+
+      timpi_call_mpi
+        (TIMPI_IMRECV(buffer->data(), count.count(), count.type(),
+                      stat.matched_message(), req.get()));
+
+      // The MessageTag should stay registered for the Request lifetime
+      req.add_post_wait_work
+        (new PostWaitDereferenceTag(tag));
+    }
+  else
+    this->receive(src_processor_id, *buffer, req, tag);
+
+  // Make the Request::wait() handle decompressing and then unpacking
+  // the buffer
+  if (this->packed_compression() != NO_COMPRESSION)
+    req.add_post_wait_work
+      (new PostWaitDecompressBuffer<std::vector<typename Packing<T>::buffer_type>>
+       (*buffer, this->packed_compression()));
 
-  // Make the Request::wait() handle unpacking the buffer
   req.add_post_wait_work
     (new PostWaitUnpackBuffer<std::vector<typename Packing<T>::buffer_type>, Context, OutputIter, T>(*buffer, context, out));
 
@@ -1979,22 +2391,31 @@ inline bool Communicator::possibly_receive (unsigned int & src_processor_id,
   timpi_assert(src_processor_id < this->size() ||
                   src_processor_id == any_source);
 
-  timpi_call_mpi(MPI_Iprobe(int(src_processor_id),
-                            tag.value(),
-                            this->get(),
-                            &int_flag,
-                            stat.get()));
+  // Use a matched probe, so that the message we size our buffer for
+  // is the message we receive, even if another thread is probing
+  // for the same source and tag.
+  MPI_Message message;
+
+  timpi_call_mpi(MPI_Improbe(int(src_processor_id),
+                             tag.value(),
+                             this->get(),
+                             &int_flag,
+                             &message,
+                             stat.get()));
 
   if (int_flag)
   {
-    buf.resize(stat.size());
+    buf.resize(stat.large_size());
+
+    TIMPI_LOG_BYTES(buf.size() * sizeof(T));
 
     src_processor_id = stat.source();
 
+    const LargeCount count(buf.size(), type, this->large_count_threshold());
+
     timpi_call_mpi
-      (TIMPI_IRECV(buf.data(), cast_int<CountType>(buf.size()), type,
-                   src_processor_id, tag.value(), this->get(),
-                   req.get()));
+      (TIMPI_IMRECV(buf.data(), count.count(), count.type(),
+                    &message, req.get()));
 
     // The MessageTag should stay registered for the Request lifetime
     req.add_post_wait_work
@@ -2039,29 +2460,39 @@ inline bool Communicator::possibly_receive (unsigned int & src_processor_id,
   timpi_assert(src_processor_id < this->size() ||
                   src_processor_id == any_source);
 
-  timpi_call_mpi(MPI_Iprobe(int(src_processor_id),
-                            tag.value(),
-                            this->get(),
-                            &int_flag,
-                            stat.get()));
+  // Use a matched probe, so that the message we size our buffer for
+  // is the message we receive, even if another thread is probing
+  // for the same source and tag.
+  MPI_Message message;
+
+  timpi_call_mpi(MPI_Improbe(int(src_processor_id),
+                             tag.value(),
+                             this->get(),
+                             &int_flag,
+                             &message,
+                             stat.get()));
 
   if (int_flag)
   {
     src_processor_id = stat.source();
 
-    std::vector<char> * recvbuf =
-      new std::vector<char>(stat.size(StandardType<char>()));
+    PooledBuffer<char> recvbuf
+      (*_buffer_pool, stat.size(StandardType<char>()));
 
-    this->receive(src_processor_id, *recvbuf, MPI_PACKED, req, tag);
+    timpi_call_mpi
+      (TIMPI_IMRECV(recvbuf->data(),
+                    cast_int<CountType>(recvbuf->size()), MPI_PACKED,
+                    &message, req.get()));
 
     // When we wait on the receive, we'll unpack the temporary buffer
     req.add_post_wait_work
-      (new PostWaitUnpackNestedBuffer<std::vector<std::vector<T,A1>,A2>>
+      (new PostWaitUnpackNestedBuffer<std::vector<std::vector<T,A1>,A2>,
+                                    InternalBuffer<char>>
          (*recvbuf, buf, type, *this));
 
-    // And then we'll free the temporary buffer
+    // And then we'll release the temporary buffer
     req.add_post_wait_work
-      (new PostWaitDeleteBuffer<std::vector<char>>(recvbuf));
+      (new PostWaitReleaseBuffer<char>(_buffer_pool, recvbuf.release()));
 
     // The MessageTag should stay registered for the Request lifetime
     req.add_post_wait_work
@@ -2231,13 +2662,15 @@ inline void Communicator::minloc(std::vector<T,A1> & r,
 
       timpi_assert(this->verify(r.size()));
 
-      std::vector<DataPlusInt<T>> data_in(r.size());
+      PooledBuffer<DataPlusInt<T>> data_in_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<T>> & data_in = *data_in_buf;
       for (std::size_t i=0; i != r.size(); ++i)
         {
           data_in[i].val  = r[i];
           data_in[i].rank = this->rank();
         }
-      std::vector<DataPlusInt<T>> data_out(r.size());
+      PooledBuffer<DataPlusInt<T>> data_out_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<T>> & data_out = *data_out_buf;
 
       timpi_call_mpi
         (TIMPI_ALLREDUCE (data_in.data(), data_out.data(),
@@ -2249,6 +2682,7 @@ inline void Communicator::minloc(std::vector<T,A1> & r,
           r[i]      = data_out[i].val;
           min_id[i] = data_out[i].rank;
         }
+
     }
   else if (!r.empty())
     {
@@ -2268,13 +2702,15 @@ inline void Communicator::minloc(std::vector<bool,A1> & r,
 
       timpi_assert(this->verify(r.size()));
 
-      std::vector<DataPlusInt<int>> data_in(r.size());
+      PooledBuffer<DataPlusInt<int>> data_in_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<int>> & data_in = *data_in_buf;
       for (std::size_t i=0; i != r.size(); ++i)
         {
           data_in[i].val  = r[i];
           data_in[i].rank = this->rank();
         }
-      std::vector<DataPlusInt<int>> data_out(r.size());
+      PooledBuffer<DataPlusInt<int>> data_out_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<int>> & data_out = *data_out_buf;
       timpi_call_mpi
         (TIMPI_ALLREDUCE
           (data_in.data(), data_out.data(),
@@ -2285,6 +2721,7 @@ inline void Communicator::minloc(std::vector<bool,A1> & r,
           r[i]      = data_out[i].val;
           min_id[i] = data_out[i].rank;
         }
+
     }
   else if (!r.empty())
     {
@@ -2468,13 +2905,15 @@ inline void Communicator::maxloc(std::vector<T,A1> & r,
 
       timpi_assert(this->verify(r.size()));
 
-      std::vector<DataPlusInt<T>> data_in(r.size());
+      PooledBuffer<DataPlusInt<T>> data_in_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<T>> & data_in = *data_in_buf;
       for (std::size_t i=0; i != r.size(); ++i)
         {
           data_in[i].val  = r[i];
           data_in[i].rank = this->rank();
         }
-      std::vector<DataPlusInt<T>> data_out(r.size());
+      PooledBuffer<DataPlusInt<T>> data_out_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<T>> & data_out = *data_out_buf;
 
       timpi_call_mpi
         (TIMPI_ALLREDUCE(data_in.data(), data_out.data(),
@@ -2487,6 +2926,7 @@ inline void Communicator::maxloc(std::vector<T,A1> & r,
           r[i]      = data_out[i].val;
           max_id[i] = data_out[i].rank;
         }
+
     }
   else if (!r.empty())
     {
@@ -2506,13 +2946,15 @@ inline void Communicator::maxloc(std::vector<bool,A1> & r,
 
       timpi_assert(this->verify(r.size()));
 
-      std::vector<DataPlusInt<int>> data_in(r.size());
+      PooledBuffer<DataPlusInt<int>> data_in_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<int>> & data_in = *data_in_buf;
       for (std::size_t i=0; i != r.size(); ++i)
         {
           data_in[i].val  = r[i];
           data_in[i].rank = this->rank();
         }
-      std::vector<DataPlusInt<int>> data_out(r.size());
+      PooledBuffer<DataPlusInt<int>> data_out_buf(*_buffer_pool, r.size());
+      InternalBuffer<DataPlusInt<int>> & data_out = *data_out_buf;
       timpi_call_mpi
         (TIMPI_ALLREDUCE(data_in.data(), data_out.data(),
                          cast_int<CountType>(r.size()),
@@ -2524,6 +2966,7 @@ inline void Communicator::maxloc(std::vector<bool,A1> & r,
           r[i]      = data_out[i].val;
           max_id[i] = data_out[i].rank;
         }
+
     }
   else if (!r.empty())
     {
@@ -2537,6 +2980,7 @@ inline void Communicator::maxloc(std::vector<bool,A1> & r,
   inline void Communicator::OPNAME(T &timpi_mpi_var(r)) const {                \
     if (this->size() > 1) {                                                    \
       TIMPI_LOG_SCOPE(#OPNAME "(scalar, blocking)", "Parallel");               \
+      TIMPI_LOG_BYTES(sizeof(T));                                              \
                                                                                \
       timpi_call_mpi(TIMPI_ALLREDUCE(MPI_IN_PLACE, &r, 1, StandardType<T>(&r), \
                                      OpFunction<T>::OPNAME(), this->get()));   \
@@ -2547,6 +2991,7 @@ inline void Communicator::maxloc(std::vector<bool,A1> & r,
   inline void Communicator::OPNAME(std::vector<T, A> &r) const {               \
     if (this->size() > 1 && !r.empty()) {                                      \
       TIMPI_LOG_SCOPE(#OPNAME "(vector, blocking)", "Parallel");               \
+      TIMPI_LOG_BYTES(r.size() * sizeof(T));                                   \
                                                                                \
       timpi_assert(this->verify(r.size()));                                    \
                                                                                \
@@ -2559,6 +3004,7 @@ inline void Communicator::maxloc(std::vector<bool,A1> & r,
   inline void Communicator::OPNAME(const T &r, T &o, Request &req) const {     \
     if (this->size() > 1) {                                                    \
       TIMPI_LOG_SCOPE(#OPNAME "(scalar, nonblocking)", "Parallel");            \
+      TIMPI_LOG_BYTES(sizeof(T));                                              \
                                                                                \
       timpi_call_mpi(TIMPI_IALLREDUCE(&r, &o, 1, StandardType<T>(&r),          \
                                       OpFunction<T>::OPNAME(), this->get(),    \
@@ -2707,6 +3153,92 @@ inline void Communicator::sum(std::unordered_map<K,V,H,E,A> & data) const
 
 
 
+template <typename T>
+inline void Communicator::gatherv_impl(const T * sendbuf,
+                                       const std::vector<std::size_t> & sendlengths,
+                                       T * recvbuf,
+                                       const DataType & type,
+                                       const unsigned int root_id,
+                                       const bool all_gather) const
+{
+  timpi_assert_equal_to(sendlengths.size(), this->size());
+  timpi_assert_less(root_id, this->size());
+
+  std::size_t globalsize = 0;
+  for (unsigned int i=0; i != this->size(); ++i)
+    globalsize += sendlengths[i];
+
+  const std::size_t max_count =
+    std::min(this->large_count_threshold(),
+             std::size_t(std::numeric_limits<CountType>::max()));
+
+  if (globalsize <= max_count)
+    {
+      std::vector<CountType>
+        counts       (this->size(), 0);
+      std::vector<DispType>
+        displacements(this->size(), 0);
+
+      CountType offset = 0;
+      for (unsigned int i=0; i != this->size(); ++i)
+        {
+          counts[i] = CountType(sendlengths[i]);
+          displacements[i] = offset;
+          offset += counts[i];
+        }
+
+      if (all_gather)
+        timpi_call_mpi
+          (TIMPI_ALLGATHERV(const_cast<T*>(sendbuf), counts[this->rank()], type,
+                            recvbuf, counts.data(), displacements.data(),
+                            type, this->get()));
+      else
+        timpi_call_mpi
+          (TIMPI_GATHERV(const_cast<T*>(sendbuf), counts[this->rank()], type,
+                         recvbuf, counts.data(), displacements.data(),
+                         type, root_id, this->get()));
+      return;
+    }
+
+  // Too much data for one MPI call to describe, at least without the
+  // MPI 4 large-count functions.  Each processor's contribution may
+  // still be too large for a plain count, but LargeCount handles that.
+  const MessageTag tag = this->get_unique_tag();
+
+  std::size_t offset = 0;
+  for (unsigned int p=0; p != this->size(); ++p)
+    {
+      const std::size_t n = sendlengths[p];
+      T * slice = recvbuf ? recvbuf + offset : nullptr;
+      offset += n;
+
+      if (!n)
+        continue;
+
+      const LargeCount count(n, type, this->large_count_threshold());
+
+      if (p == this->rank() && (all_gather || p == root_id))
+        std::copy(sendbuf, sendbuf + n, slice);
+
+      if (all_gather)
+        timpi_call_mpi
+          (TIMPI_BCAST(slice, count.count(), count.type(), p,
+                       this->get()));
+      else if (p == root_id)
+        continue;
+      else if (p == this->rank())
+        timpi_call_mpi
+          (TIMPI_SEND(const_cast<T*>(sendbuf), count.count(),
+                      count.type(), root_id, tag.value(), this->get()));
+      else if (root_id == this->rank())
+        timpi_call_mpi
+          (TIMPI_RECV(slice, count.count(), count.type(), p,
+                      tag.value(), this->get(), MPI_STATUS_IGNORE));
+    }
+}
+
+
+
 template <typename T, typename A1, typename A2,
           typename std::enable_if<std::is_base_of<DataType, StandardType<T>>::value, int>::type>
 inline void Communicator::allgather(const std::vector<T,A1> & sendval,
@@ -2728,12 +3260,9 @@ inline void Communicator::allgather(const std::vector<T,A1> & sendval,
   recv.clear();
   recv.resize(this->size());
 
-  std::vector<CountType>
-    sendlengths  (this->size(), 0);
-  std::vector<DispType>
-    displacements(this->size(), 0);
+  std::vector<std::size_t> sendlengths(this->size(), 0);
 
-  const CountType mysize = cast_int<CountType>(sendval.size());
+  const std::size_t mysize = sendval.size();
 
   if (identical_buffer_sizes)
     sendlengths.assign(this->size(), mysize);
@@ -2741,33 +3270,31 @@ inline void Communicator::allgather(const std::vector<T,A1> & sendval,
     // first comm step to determine buffer sizes from all processors
     this->allgather(mysize, sendlengths);
 
-  // Find the total size of the final array and
-  // set up the displacement offsets for each processor
-  CountType globalsize = 0;
+  // Find the total size of the final array
+  std::size_t globalsize = 0;
   for (unsigned int i=0; i != this->size(); ++i)
-    {
-      displacements[i] = globalsize;
-      globalsize += sendlengths[i];
-    }
+    globalsize += sendlengths[i];
 
   // Check for quick return
   if (globalsize == 0)
     return;
 
   // monolithic receive buffer
-  std::vector<T,A1> r(globalsize, 0);
+  PooledBuffer<T> r_buf(*_buffer_pool, globalsize);
+  InternalBuffer<T> & r = *r_buf;
 
   // and get the data from the remote processors.
-  timpi_call_mpi
-    (TIMPI_ALLGATHERV(const_cast<T*>(mysize ? sendval.data() : nullptr),
-                      mysize, StandardType<T>(),
-                      &r[0], sendlengths.data(), displacements.data(),
-                      StandardType<T>(), this->get()));
+  this->gatherv_impl(mysize ? sendval.data() : nullptr, sendlengths,
+                     r.data(), StandardType<T>(), 0, true);
 
   // slice receive buffer up
+  std::size_t offset = 0;
   for (unsigned int i=0; i != this->size(); ++i)
-    recv[i].assign(r.begin()+displacements[i],
-                   r.begin()+displacements[i]+sendlengths[i]);
+    {
+      recv[i].assign(r.begin()+offset, r.begin()+offset+sendlengths[i]);
+      offset += sendlengths[i];
+    }
+
 }
 
 
@@ -2785,10 +3312,12 @@ inline void Communicator::allgather(const std::vector<T,A1> & sendval,
   std::vector<buffer_t> buffer;
   auto next_iter = pack_range ((void *)nullptr, sendval.begin(),
                                sendval.end(), buffer,
-                               std::numeric_limits<CountType>::max());
+                               std::numeric_limits<std::size_t>::max());
+  timpi_assert(next_iter == sendval.end());
+  timpi_ignore(next_iter);
 
-  if (next_iter != sendval.end())
-    timpi_error_msg("Non-blocking packed range sends cannot exceed " << std::numeric_limits<CountType>::max() << "in size");
+  compress_packed_buffer(buffer, this->packed_compression(),
+                         this->packed_compression_threshold());
 
   std::vector<std::vector<buffer_t>> allbuffers;
 
@@ -2801,8 +3330,11 @@ inline void Communicator::allgather(const std::vector<T,A1> & sendval,
   this->allgather(buffer, allbuffers, false);
 
   for (processor_id_type i=0; i != this->size(); ++i)
-    unpack_range(allbuffers[i], (void *)nullptr,
-                 std::back_inserter(recv[i]), (T*)nullptr);
+    {
+      decompress_packed_buffer(allbuffers[i], this->packed_compression());
+      unpack_range(allbuffers[i], (void *)nullptr,
+                   std::back_inserter(recv[i]), (T*)nullptr);
+    }
 }
 
 
@@ -2812,12 +3344,7 @@ inline void Communicator::set_union(std::set<T,C,A> & data,
                                     const unsigned int root_id) const
 {
   if (this->size() > 1)
-    {
-      std::vector<T> vecdata(data.begin(), data.end());
-      this->gather(root_id, vecdata);
-      if (this->rank() == root_id)
-        data.insert(vecdata.begin(), vecdata.end());
-    }
+    this->set_union_impl(data, root_id, false);
 }
 
 
@@ -2826,11 +3353,49 @@ template <typename T, typename C, typename A>
 inline void Communicator::set_union(std::set<T,C,A> & data) const
 {
   if (this->size() > 1)
-    {
-      std::vector<T> vecdata(data.begin(), data.end());
-      this->allgather(vecdata, false);
-      data.insert(vecdata.begin(), vecdata.end());
-    }
+    this->set_union_impl(data, 0, true);
+}
+
+
+
+template <typename Set,
+          typename std::enable_if<!HasSortedIntegerKeys<Set>::value, int>::type>
+inline void Communicator::set_union_impl(Set & data,
+                                         const unsigned int root_id,
+                                         const bool all_gather) const
+{
+  std::vector<typename Set::value_type> vecdata(data.begin(), data.end());
+  if (all_gather)
+    this->allgather(vecdata, false);
+  else
+    this->gather(root_id, vecdata);
+
+  if (all_gather || this->rank() == root_id)
+    data.insert(vecdata.begin(), vecdata.end());
+}
+
+
+
+template <typename Set,
+          typename std::enable_if<HasSortedIntegerKeys<Set>::value, int>::type>
+inline void Communicator::set_union_impl(Set & data,
+                                         const unsigned int root_id,
+                                         const bool all_gather) const
+{
+  std::vector<unsigned char> buffer;
+  encode_sorted_integers<typename Set::key_type>
+    (data.begin(), data.end(), data.size(), buffer);
+
+  if (all_gather)
+    this->allgather(buffer, false);
+  else
+    this->gather(root_id, buffer);
+
+  // Each processor's keys arrive sorted, so hinting at the end makes
+  // most insertions constant time
+  if (all_gather || this->rank() == root_id)
+    decode_sorted_integers<typename Set::key_type>
+      (buffer, std::inserter(data, data.end()));
 }
 
 
@@ -3136,31 +3701,26 @@ inline void Communicator::gather(const unsigned int root_id,
 
   timpi_assert_less (root_id, this->size());
 
-  std::vector<CountType>
-    sendlengths  (this->size(), 0);
-  std::vector<DispType>
-    displacements(this->size(), 0);
+  std::vector<std::size_t> sendlengths(this->size(), 0);
 
-  const CountType mysize = cast_int<CountType>(r.size());
+  const std::size_t mysize = r.size();
   this->allgather(mysize, sendlengths);
 
   TIMPI_LOG_SCOPE("gather()", "Parallel");
 
-  // Find the total size of the final array and
-  // set up the displacement offsets for each processor.
-  CountType globalsize = 0;
+  // Find the total size of the final array
+  std::size_t globalsize = 0;
   for (unsigned int i=0; i != this->size(); ++i)
-    {
-      displacements[i] = globalsize;
-      globalsize += sendlengths[i];
-    }
+    globalsize += sendlengths[i];
 
   // Check for quick return
   if (globalsize == 0)
     return;
 
   // copy the input buffer
-  std::vector<T,A> r_src(r);
+  PooledBuffer<T> r_src_buf(*_buffer_pool, r.size());
+  InternalBuffer<T> & r_src = *r_src_buf;
+  std::copy(r.begin(), r.end(), r_src.begin());
 
   // now resize it to hold the global data
   // on the receiving processor
@@ -3170,11 +3730,10 @@ inline void Communicator::gather(const unsigned int root_id,
   timpi_assert_less(root_id, this->size());
 
   // and get the data from the remote processors
-  timpi_call_mpi
-    (TIMPI_GATHERV(r_src.empty() ? nullptr : r_src.data(), mysize,
-                   StandardType<T>(), r.empty() ? nullptr : r.data(),
-                   sendlengths.data(), displacements.data(),
-                   StandardType<T>(), root_id, this->get()));
+  this->gatherv_impl(r_src.empty() ? nullptr : r_src.data(), sendlengths,
+                     (root_id == this->rank()) ? r.data() : nullptr,
+                     StandardType<T>(), root_id, false);
+
 }
 
 
@@ -3321,34 +3880,34 @@ inline void Communicator::allgather(std::vector<T,A> & r,
       if (r.empty())
         return;
 
-      std::vector<T,A> r_src(r.size()*this->size());
-      r_src.swap(r);
-      StandardType<T> send_type(r_src.data());
+      const std::size_t globalsize = r.size()*this->size();
 
-      timpi_call_mpi
-        (TIMPI_ALLGATHER(r_src.data(), cast_int<CountType>(r_src.size()),
-                         send_type, r.data(), cast_int<CountType>(r_src.size()),
-                         send_type, this->get()));
-      // timpi_assert(this->verify(r));
-      return;
+      // Otherwise we'll let gatherv_impl() split things up
+      if (globalsize <= this->large_count_threshold() &&
+          globalsize <= std::size_t(std::numeric_limits<CountType>::max()))
+        {
+          std::vector<T,A> r_src(globalsize);
+          r_src.swap(r);
+          StandardType<T> send_type(r_src.data());
+
+          timpi_call_mpi
+            (TIMPI_ALLGATHER(r_src.data(), cast_int<CountType>(r_src.size()),
+                             send_type, r.data(), cast_int<CountType>(r_src.size()),
+                             send_type, this->get()));
+          // timpi_assert(this->verify(r));
+          return;
+        }
     }
 
-  std::vector<CountType>
-    sendlengths  (this->size(), 0);
-  std::vector<DispType>
-    displacements(this->size(), 0);
+  std::vector<std::size_t> sendlengths(this->size(), r.size());
 
-  const CountType mysize = cast_int<CountType>(r.size());
-  this->allgather(mysize, sendlengths);
+  if (!identical_buffer_sizes)
+    this->allgather(r.size(), sendlengths);
 
-  // Find the total size of the final array and
-  // set up the displacement offsets for each processor.
-  CountType globalsize = 0;
+  // Find the total size of the final array
+  std::size_t globalsize = 0;
   for (unsigned int i=0; i != this->size(); ++i)
-    {
-      displacements[i] = globalsize;
-      globalsize += sendlengths[i];
-    }
+    globalsize += sendlengths[i];
 
   // Check for quick return
   if (globalsize == 0)
@@ -3362,10 +3921,8 @@ inline void Communicator::allgather(std::vector<T,A> & r,
 
   // and get the data from the remote processors.
   // Pass nullptr if our vector is empty.
-  timpi_call_mpi
-    (TIMPI_ALLGATHERV(r_src.empty() ? nullptr : r_src.data(), mysize,
-                      send_type, r.data(), sendlengths.data(),
-                      displacements.data(), send_type, this->get()));
+  this->gatherv_impl(r_src.empty() ? nullptr : r_src.data(), sendlengths,
+                     r.data(), send_type, 0, true);
 }
 
 template <typename T, typename A,
@@ -3755,6 +4312,8 @@ inline void Communicator::broadcast (T & timpi_mpi_var(data),
 
   TIMPI_LOG_SCOPE("broadcast()", "Parallel");
 
+  TIMPI_LOG_BYTES(sizeof(T));
+
   // Spread data to remote processors.
   timpi_call_mpi
     (TIMPI_BCAST(&data, 1, StandardType<T>(&data), root_id,
@@ -3834,9 +4393,48 @@ inline void Communicator::broadcast (std::vector<T,A> & timpi_mpi_var(data),
 
   timpi_assert_less(root_id, this->size());
 
+  TIMPI_LOG_BYTES(data.size() * sizeof(T));
+
+  // The LargeCount may just hold on to our type, so keep it alive
+  StandardType<T> type(data_ptr);
+  const LargeCount count(data.size(), type, this->large_count_threshold());
+
   timpi_call_mpi
-    (TIMPI_BCAST(data_ptr, cast_int<CountType>(data.size()),
-                 StandardType<T>(data_ptr), root_id, this->get()));
+    (TIMPI_BCAST(data_ptr, count.count(), count.type(), root_id,
+                 this->get()));
+#endif
+}
+
+template <typename T, typename A>
+inline void Communicator::broadcast (std::vector<T,A> & timpi_mpi_var(data),
+                                     const VectorSubset & timpi_mpi_var(subset),
+                                     const unsigned int root_id) const
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be broadcast into a VectorSubset");
+
+  ignore(root_id); // Only needed for MPI and/or dbg/devel
+  if (this->size() == 1)
+    {
+      timpi_assert (!this->rank());
+      timpi_assert (!root_id);
+      return;
+    }
+
+#ifdef TIMPI_HAVE_MPI
+  timpi_assert_less (root_id, this->size());
+  timpi_assert_greater_equal(data.size(), subset.required_size());
+
+  TIMPI_LOG_SCOPE("broadcast()", "Parallel");
+
+  TIMPI_LOG_BYTES(subset.size() * sizeof(T));
+
+  T * data_ptr = subset.size() ? data.data() + subset.offset() : nullptr;
+  StandardType<T> base(data_ptr);
+  const std::shared_ptr<const DataType> type = subset.datatype(base);
+
+  timpi_call_mpi
+    (MPI_Bcast(data_ptr, 1, *type, root_id, this->get()));
 #endif
 }
 
@@ -3879,7 +4477,8 @@ inline void Communicator::broadcast (std::vector<T,A> & data,
 
 template <typename Map,
           typename std::enable_if<std::is_base_of<DataType, StandardType<typename Map::key_type>>::value &&
-                                  std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value,
+                                  std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value &&
+                                  !HasSortedIntegerKeys<Map>::value,
                                   int>::type>
 inline void Communicator::map_broadcast(Map & timpi_mpi_var(data),
                                         const unsigned int root_id,
@@ -3925,7 +4524,8 @@ inline void Communicator::map_broadcast(Map & timpi_mpi_var(data),
 
 template <typename Map,
           typename std::enable_if<!(std::is_base_of<DataType, StandardType<typename Map::key_type>>::value &&
-                                    std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value),
+                                    std::is_base_of<DataType, StandardType<typename Map::mapped_type>>::value) &&
+                                  !HasSortedIntegerKeys<Map>::value,
                                   int>::type>
 inline void Communicator::map_broadcast(Map & timpi_mpi_var(data),
                                         const unsigned int root_id,
@@ -3986,6 +4586,76 @@ inline void Communicator::map_broadcast(Map & timpi_mpi_var(data),
 #endif
 }
 
+template <typename Map,
+          typename std::enable_if<HasSortedIntegerKeys<Map>::value,
+                                  int>::type>
+inline void Communicator::map_broadcast(Map & timpi_mpi_var(data),
+                                        const unsigned int root_id,
+                                        const bool timpi_mpi_var(identical_sizes)) const
+{
+  ignore(root_id); // Only needed for MPI and/or dbg/devel
+  if (this->size() == 1)
+    {
+      timpi_assert (!this->rank());
+      timpi_assert (!root_id);
+      return;
+    }
+
+#ifdef TIMPI_HAVE_MPI
+  timpi_assert_less (root_id, this->size());
+  timpi_assert (this->verify(identical_sizes));
+
+  TIMPI_LOG_SCOPE("broadcast(map)", "Parallel");
+
+  typedef typename Map::key_type key_type;
+  typedef typename Map::mapped_type mapped_type;
+
+  std::vector<unsigned char> keys;
+  std::vector<mapped_type> values;
+
+  if (root_id == this->rank())
+    {
+      std::vector<key_type> key_list;
+      key_list.reserve(data.size());
+      values.reserve(data.size());
+      for (const auto & pr : data)
+        {
+          key_list.push_back(pr.first);
+          values.push_back(pr.second);
+        }
+      encode_sorted_integers<key_type>
+        (key_list.begin(), key_list.end(), key_list.size(), keys);
+    }
+
+  // The number of entries and of encoded key bytes, in one broadcast
+  std::vector<std::size_t> sizes {data.size(), keys.size()};
+  if (identical_sizes)
+    timpi_assert(this->verify(sizes[0]));
+  this->broadcast(sizes, root_id, true);
+
+  if (root_id != this->rank())
+    {
+      values.resize(sizes[0]);
+      keys.resize(sizes[1]);
+    }
+
+  this->broadcast(keys, root_id, true);
+  this->broadcast(values, root_id, StandardType<mapped_type>::is_fixed_type);
+
+  if (this->rank() != root_id)
+    {
+      std::vector<key_type> decoded_keys;
+      decoded_keys.reserve(sizes[0]);
+      decode_sorted_integers<key_type>(keys, std::back_inserter(decoded_keys));
+      timpi_assert_equal_to(decoded_keys.size(), values.size());
+
+      data.clear();
+      for (std::size_t i=0; i != values.size(); ++i)
+        data.emplace_hint(data.end(), decoded_keys[i], std::move(values[i]));
+    }
+#endif
+}
+
 template <typename T1, typename T2, typename C, typename A>
 inline void Communicator::broadcast(std::map<T1,T2,C,A> & data,
                                     const unsigned int root_id,
@@ -4031,8 +4701,12 @@ inline void Communicator::broadcast_packed_range(const Context * context1,
     std::vector<buffer_t> buffer;
 
     if (this->rank() == root_id)
-      range_begin = pack_range
-        (context1, range_begin, range_end, buffer, approx_buffer_size);
+      {
+        range_begin = pack_range
+          (context1, range_begin, range_end, buffer, approx_buffer_size);
+        compress_packed_buffer(buffer, this->packed_compression(),
+                               this->packed_compression_threshold());
+      }
 
     // this->broadcast(vector) requires the receiving vectors to
     // already be the appropriate size
@@ -4055,6 +4729,7 @@ inline void Communicator::broadcast_packed_range(const Context * context1,
 
     if (this->rank() != root_id)
       {
+        decompress_packed_buffer(buffer, this->packed_compression());
         auto return_out_iter = unpack_range
           (buffer, context2, *next_out_iter, (T*)nullptr);
         next_out_iter = std::make_unique<OutputIter>(return_out_iter);
@@ -4091,8 +4766,13 @@ inline void Communicator::gather_packed_range(const unsigned int root_id,
       range_begin = pack_range
         (context, range_begin, range_end, buffer, approx_buffer_size);
 
+      compress_packed_buffer(buffer, this->packed_compression(),
+                             this->packed_compression_threshold());
+
       this->gather(root_id, buffer);
 
+      decompress_packed_buffer(buffer, this->packed_compression());
+
       auto return_out_iter = unpack_range
         (buffer, context, *next_out_iter, (T*)(nullptr));
       next_out_iter = std::make_unique<OutputIter>(return_out_iter);
@@ -4130,10 +4810,15 @@ inline void Communicator::allgather_packed_range(Context * context,
       range_begin = pack_range
         (context, range_begin, range_end, buffer, approx_buffer_size);
 
+      compress_packed_buffer(buffer, this->packed_compression(),
+                             this->packed_compression_threshold());
+
       this->allgather(buffer, false);
 
       timpi_assert(buffer.size());
 
+      decompress_packed_buffer(buffer, this->packed_compression());
+
       auto return_out_iter = unpack_range
         (buffer, context, *next_out_iter, (T*)nullptr);
       next_out_iter = std::make_unique<OutputIter>(return_out_iter);
@@ -4174,6 +4859,38 @@ inline Status Communicator::packed_range_probe (const unsigned int src_processor
 
 
 
+template<typename T>
+inline Status Communicator::packed_range_matched_probe (const unsigned int src_processor_id,
+                                                        const MessageTag & tag,
+                                                        bool & flag) const
+{
+  TIMPI_LOG_SCOPE("packed_range_matched_probe()", "Parallel");
+
+  ignore(src_processor_id, tag); // unused in opt mode w/o MPI
+
+  Status stat((StandardType<typename Packing<T>::buffer_type>()));
+
+  int int_flag = 0;
+
+  timpi_assert(src_processor_id < this->size() ||
+               src_processor_id == any_source);
+
+  // The message we find is then reserved for receipt via
+  // nonblocking_receive_packed_range() with this Status
+  timpi_call_mpi(MPI_Improbe(int(src_processor_id),
+                             tag.value(),
+                             this->get(),
+                             &int_flag,
+                             stat.matched_message(),
+                             stat.get()));
+
+  flag = int_flag;
+
+  return stat;
+}
+
+
+
 template <typename T, typename A,
           typename std::enable_if<std::is_base_of<DataType, StandardType<T>>::value, int>::type>
 inline bool Communicator::possibly_receive (unsigned int & src_processor_id,
@@ -4227,7 +4944,7 @@ inline bool Communicator::possibly_receive_packed_range (unsigned int & src_proc
 
   bool int_flag = 0;
 
-  auto stat = packed_range_probe<T>(src_processor_id, tag, int_flag);
+  auto stat = packed_range_matched_probe<T>(src_processor_id, tag, int_flag);
 
   if (int_flag)
   {
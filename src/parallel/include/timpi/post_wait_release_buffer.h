@@ -0,0 +1,51 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_POST_WAIT_RELEASE_BUFFER_H
+#define TIMPI_POST_WAIT_RELEASE_BUFFER_H
+
+// TIMPI includes
+#include "timpi/buffer_pool.h"
+#include "timpi/post_wait_work.h"
+
+// C++ includes
+#include <memory>
+#include <vector>
+
+namespace TIMPI
+{
+
+// PostWaitWork specialization for returning no-longer-needed buffers
+// to the BufferPool they came from.  We share ownership of the pool,
+// in case the Request outlives its Communicator.
+template <typename T, typename A = InternalAllocator<T>>
+struct PostWaitReleaseBuffer : public PostWaitWork {
+  PostWaitReleaseBuffer(std::shared_ptr<BufferPool> pool,
+                        std::vector<T,A> * buffer) :
+    _pool(std::move(pool)), _buf(buffer) {}
+
+  virtual void run() override { _pool->release(_buf); }
+
+private:
+  std::shared_ptr<BufferPool> _pool;
+  std::vector<T,A> * _buf;
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_POST_WAIT_RELEASE_BUFFER_H
@@ -29,9 +29,9 @@ namespace TIMPI
 
 // PostWaitWork specialization for MPI_Unpack of nested buffers.
 // Container will most likely be vector<vector<T>>
-template <typename Container>
+template <typename Container, typename Buffer = std::vector<char>>
 struct PostWaitUnpackNestedBuffer : public PostWaitWork {
-  PostWaitUnpackNestedBuffer(const std::vector<char> & buffer,
+  PostWaitUnpackNestedBuffer(const Buffer & buffer,
                              Container & out,
                              const DataType & timpi_mpi_var(T_type),
                              const Communicator & comm_in) :
@@ -95,7 +95,7 @@ struct PostWaitUnpackNestedBuffer : public PostWaitWork {
   }
 
 private:
-  const std::vector<char> & recvbuf;
+  const Buffer & recvbuf;
   Container & recv;
   DataType type;
   const Communicator & comm;
@@ -39,10 +39,7 @@
 #include "timpi/request.h"
 #include "timpi/status.h"
 #include "timpi/standard_type.h"
-
-// Disable libMesh logging until we decide how to port it best
-// #include "libmesh/libmesh_logging.h"
-#define TIMPI_LOG_SCOPE(f,c)
+#include "timpi/timpi_profiler.h"
 
 // C++ includes
 #include <cstddef>
@@ -97,6 +94,24 @@ inline void Communicator::send (const unsigned int,
                                 const MessageTag &) const
 { timpi_not_implemented(); }
 
+template <typename T>
+inline void Communicator::send (const unsigned int,
+                                const T &,
+                                const DataType &,
+                                Request &,
+                                const MessageTag &,
+                                const SendMode) const
+{ timpi_not_implemented(); }
+
+template <typename T>
+inline void Communicator::send (const unsigned int,
+                                const T &,
+                                const NotADataType &,
+                                Request &,
+                                const MessageTag &,
+                                const SendMode) const
+{ timpi_not_implemented(); }
+
 template <typename Context, typename Iter>
 inline void Communicator::send_packed_range(const unsigned int,
                                             const Context *,
@@ -125,6 +140,16 @@ inline void Communicator::nonblocking_send_packed_range (const unsigned int,
                                                          const MessageTag &) const
 { timpi_not_implemented(); }
 
+template <typename Context, typename Iter>
+inline void Communicator::nonblocking_send_packed_range (const unsigned int,
+                                                         const Context *,
+                                                         Iter,
+                                                         const Iter,
+                                                         Request &,
+                                                         const MessageTag &,
+                                                         const SendMode) const
+{ timpi_not_implemented(); }
+
 template <typename Context, typename OutputIter, typename T>
 inline void Communicator::nonblocking_receive_packed_range (const unsigned int,
                                                             Context *,
@@ -166,6 +191,36 @@ inline void Communicator::receive(const unsigned int,
                                   const MessageTag &) const
 { timpi_not_implemented(); }
 
+template <typename T, typename A>
+inline void Communicator::send (const unsigned int,
+                                const std::vector<T,A> &,
+                                const VectorSubset &,
+                                const MessageTag &) const
+{ timpi_not_implemented(); }
+
+template <typename T, typename A>
+inline void Communicator::send (const unsigned int,
+                                const std::vector<T,A> &,
+                                const VectorSubset &,
+                                Request &,
+                                const MessageTag &) const
+{ timpi_not_implemented(); }
+
+template <typename T, typename A>
+inline Status Communicator::receive (const unsigned int,
+                                     std::vector<T,A> &,
+                                     const VectorSubset &,
+                                     const MessageTag &) const
+{ timpi_not_implemented(); return Status(); }
+
+template <typename T, typename A>
+inline void Communicator::receive (const unsigned int,
+                                   std::vector<T,A> &,
+                                   const VectorSubset &,
+                                   Request &,
+                                   const MessageTag &) const
+{ timpi_not_implemented(); }
+
 template <typename Context, typename OutputIter, typename T>
 inline void
 Communicator::receive_packed_range(const unsigned int,
@@ -0,0 +1,202 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_SORTED_INTEGER_ENCODING_H
+#define TIMPI_SORTED_INTEGER_ENCODING_H
+
+// TIMPI includes
+#include "timpi/timpi_assert.h"
+
+// C++ includes
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace TIMPI
+{
+
+/**
+ * Whether keys of type T, ordered by Compare, are integers visited
+ * in increasing order, so that the sorted integer encoding applies.
+ */
+template <typename T, typename Compare>
+struct IsSortedIntegerKey :
+    std::integral_constant<bool,
+                           std::is_integral<T>::value &&
+                           !std::is_same<T, bool>::value &&
+                           std::is_same<Compare, std::less<T>>::value> {};
+
+/**
+ * Whether an associative Container (e.g. std::set or std::map, but
+ * not the unordered containers) has sorted integer keys.
+ */
+template <typename Container, typename Enable = void>
+struct HasSortedIntegerKeys : std::false_type {};
+
+template <typename Container>
+struct HasSortedIntegerKeys
+  <Container,
+   typename std::enable_if<IsSortedIntegerKey<typename Container::key_type,
+                                              typename Container::key_compare>::value>::type>
+  : std::true_type {};
+
+
+namespace detail
+{
+
+// Each encoded run of keys starts with one of these, then the key
+// count as a varint
+enum SortedIntegerFormat : unsigned char { RAW_INTEGERS = 0, DELTA_VARINT_INTEGERS };
+
+inline void put_sorted_integer_varint (std::uint64_t value,
+                                       std::vector<unsigned char> & out)
+{
+  while (value >= 0x80)
+    {
+      out.push_back((unsigned char)((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+  out.push_back((unsigned char)(value));
+}
+
+inline std::uint64_t get_sorted_integer_varint (const unsigned char * & in)
+{
+  std::uint64_t value = 0;
+  for (unsigned int shift = 0; ; shift += 7)
+    {
+      timpi_assert_less(shift, 64u);
+      const unsigned char byte = *in++;
+      value |= std::uint64_t(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return value;
+    }
+}
+
+} // namespace detail
+
+
+
+/**
+ * Appends the \p n integers in [\p begin, \p end), which must be in
+ * increasing order, to \p out as a self-delimiting run: the first
+ * key, then the gaps between successive keys, as variable-length
+ * integers.  Dense id ranges thus cost about one byte per key instead
+ * of sizeof(T).  If the gaps are so large that this would be bigger
+ * than the raw keys, the raw keys are written instead.
+ *
+ * Runs may be concatenated, e.g. by gather(), and decoded in one pass
+ * by decode_sorted_integers().
+ */
+template <typename T, typename Iter>
+inline void
+encode_sorted_integers (Iter begin,
+                        const Iter end,
+                        const std::size_t n,
+                        std::vector<unsigned char> & out)
+{
+  static_assert(std::is_integral<T>::value,
+                "Only integers can be sorted integer encoded");
+
+  const std::size_t start = out.size();
+  out.push_back(detail::DELTA_VARINT_INTEGERS);
+  detail::put_sorted_integer_varint(n, out);
+
+  const std::size_t raw_end = out.size() + n * sizeof(T);
+
+  // Converting to unsigned 64 bits is modular, so the differences
+  // between increasing signed keys come out right too
+  std::uint64_t previous = 0;
+  for (Iter it = begin; it != end; ++it)
+    {
+      const std::uint64_t current = std::uint64_t(*it);
+      detail::put_sorted_integer_varint(current - previous, out);
+      previous = current;
+
+      // Give up as soon as we know the raw keys are smaller
+      if (out.size() > raw_end)
+        break;
+    }
+
+  if (out.size() <= raw_end)
+    return;
+
+  out.resize(start);
+  out.push_back(detail::RAW_INTEGERS);
+  detail::put_sorted_integer_varint(n, out);
+  for (; begin != end; ++begin)
+    {
+      const T key = *begin;
+      const unsigned char * key_bytes =
+        reinterpret_cast<const unsigned char *>(&key);
+      out.insert(out.end(), key_bytes, key_bytes + sizeof(T));
+    }
+}
+
+
+
+/**
+ * Decodes every run written by encode_sorted_integers() in \p buffer,
+ * writing the keys to \p out.
+ */
+template <typename T, typename OutputIter>
+inline OutputIter
+decode_sorted_integers (const std::vector<unsigned char> & buffer,
+                        OutputIter out)
+{
+  const unsigned char * in = buffer.data();
+  const unsigned char * const in_end = in + buffer.size();
+
+  while (in != in_end)
+    {
+      const unsigned char format = *in++;
+      const std::uint64_t n = detail::get_sorted_integer_varint(in);
+
+      if (format == detail::RAW_INTEGERS)
+        {
+          timpi_assert_less_equal(n * sizeof(T), std::size_t(in_end - in));
+          for (std::uint64_t i = 0; i != n; ++i, in += sizeof(T))
+            {
+              T key;
+              std::memcpy(&key, in, sizeof(T));
+              *out++ = key;
+            }
+        }
+      else
+        {
+          timpi_assert_equal_to(format, detail::DELTA_VARINT_INTEGERS);
+          std::uint64_t key = 0;
+          for (std::uint64_t i = 0; i != n; ++i)
+            {
+              key += detail::get_sorted_integer_varint(in);
+              *out++ = T(key);
+            }
+        }
+
+      timpi_assert_less_equal(in, in_end);
+    }
+
+  return out;
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_SORTED_INTEGER_ENCODING_H
@@ -0,0 +1,386 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_STANDARD_TYPE_STRUCT_H
+#define TIMPI_STANDARD_TYPE_STRUCT_H
+
+// TIMPI includes
+#include "timpi/op_function.h"
+#include "timpi/standard_type.h"
+
+// C++ includes
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Defines StandardType<Type> and OpFunction<Type> specializations for
+ * a user struct, given the names of its data members:
+ *
+ * \verbatim
+ * struct PointRecord { double xyz[3]; unsigned int id; float weight; };
+ *
+ * TIMPI_STANDARD_TYPE_STRUCT(PointRecord, xyz, id, weight)
+ * \endverbatim
+ *
+ * after which PointRecord and containers of PointRecord can be sent,
+ * broadcast, gathered, etc. with a committed MPI struct datatype
+ * rather than through Packing, and can be reduced with sum(), min(),
+ * max() and product(), which act on each member separately.
+ *
+ * Every listed member must have a fixed StandardType, or be a C array
+ * or std::array of such.  Members which are not listed are not
+ * communicated.  Reductions need each member type to support the
+ * corresponding operator; std::min and std::max see array members one
+ * entry at a time.
+ *
+ * The macro must be used at global scope, with a fully qualified
+ * type name, and supports up to 16 members.
+ */
+#define TIMPI_STANDARD_TYPE_STRUCT(Type, ...)                             \
+  namespace TIMPI {                                                     \
+  template <>                                                           \
+  struct StructFields<Type>                                             \
+  {                                                                     \
+    static auto fields()                                                \
+    {                                                                   \
+      return std::make_tuple                                            \
+        (TIMPI_STRUCT_MEMBER_POINTERS(Type, __VA_ARGS__));              \
+    }                                                                   \
+  };                                                                    \
+                                                                        \
+  template <>                                                           \
+  class StandardType<Type> : public StructStandardType<Type>            \
+  {                                                                     \
+  public:                                                               \
+    explicit                                                            \
+    StandardType(const Type * example = nullptr) :                      \
+      StructStandardType<Type>(example) {}                              \
+  };                                                                    \
+                                                                        \
+  template <>                                                           \
+  class OpFunction<Type> : public StructOpFunction<Type> {};            \
+  }
+
+
+// Turn (Type, a, b, ...) into &Type::a, &Type::b, ...
+#define TIMPI_STRUCT_CAT(a, b) TIMPI_STRUCT_CAT_(a, b)
+#define TIMPI_STRUCT_CAT_(a, b) a##b
+
+#define TIMPI_STRUCT_N_ARGS(...)                                          \
+  TIMPI_STRUCT_N_ARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9,        \
+                       8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define TIMPI_STRUCT_N_ARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10,     \
+                             _11, _12, _13, _14, _15, _16, N, ...) N
+
+#define TIMPI_STRUCT_MEMBER_POINTERS(Type, ...)                           \
+  TIMPI_STRUCT_CAT(TIMPI_STRUCT_MEMBERS_, TIMPI_STRUCT_N_ARGS(__VA_ARGS__)) \
+    (Type, __VA_ARGS__)
+
+#define TIMPI_STRUCT_MEMBERS_1(T, m) &T::m
+#define TIMPI_STRUCT_MEMBERS_2(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_1(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_3(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_2(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_4(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_3(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_5(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_4(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_6(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_5(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_7(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_6(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_8(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_7(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_9(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_8(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_10(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_9(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_11(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_10(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_12(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_11(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_13(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_12(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_14(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_13(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_15(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_14(T, __VA_ARGS__)
+#define TIMPI_STRUCT_MEMBERS_16(T, m, ...) &T::m, TIMPI_STRUCT_MEMBERS_15(T, __VA_ARGS__)
+
+
+namespace TIMPI
+{
+
+/**
+ * Specialized by TIMPI_STANDARD_TYPE_STRUCT, with a static fields()
+ * function returning a tuple of pointers to the members of T which
+ * are to be communicated.
+ */
+template <typename T>
+struct StructFields;
+
+
+namespace detail
+{
+
+// The type of the member a member pointer points to
+template <typename MemberPointer>
+struct StructMember;
+
+template <typename T, typename F>
+struct StructMember<F T::*>
+{
+  typedef F type;
+};
+
+// Members are communicated as count() consecutive entries of
+// element_type, so that C arrays and std::arrays of fixed types
+// work too.
+template <typename F>
+struct StructMemberEntries
+{
+  typedef F element_type;
+  static constexpr std::size_t count() { return 1; }
+  static F * first(F & f) { return &f; }
+};
+
+template <typename F, std::size_t N>
+struct StructMemberEntries<F[N]>
+{
+  typedef F element_type;
+  static constexpr std::size_t count() { return N; }
+  static F * first(F (&f)[N]) { return f; }
+};
+
+template <typename F, std::size_t N>
+struct StructMemberEntries<std::array<F, N>>
+{
+  typedef F element_type;
+  static constexpr std::size_t count() { return N; }
+  static F * first(std::array<F, N> & f) { return f.data(); }
+};
+
+template <typename MemberPointer>
+using struct_member_element_t =
+  typename StructMemberEntries
+    <typename StructMember<MemberPointer>::type>::element_type;
+
+template <typename Fields>
+struct StructFieldsFixed;
+
+template <typename... MemberPointers>
+struct StructFieldsFixed<std::tuple<MemberPointers...>>
+{
+  static const bool value =
+    CheckAllFixedTypes<struct_member_element_t<MemberPointers>...>::is_fixed_type;
+};
+
+template <typename Fields, typename Functor, std::size_t... I>
+inline
+void for_each_struct_field(const Fields & fields,
+                           const Functor & f,
+                           std::index_sequence<I...>)
+{
+  // Expand f(field) over every field, in order
+  const int expand[] = {0, (f(std::get<I>(fields)), 0)...};
+  ignore(expand);
+}
+
+template <typename T, typename Functor>
+inline
+void for_each_struct_field(const Functor & f)
+{
+  const auto fields = StructFields<T>::fields();
+  for_each_struct_field
+    (fields, f,
+     std::make_index_sequence<std::tuple_size<decltype(fields)>::value>());
+}
+
+// Applies op entry-by-entry to every field, with MPI user function
+// semantics: inout[i] = op(in[i], inout[i])
+template <typename T, typename Op>
+inline
+void struct_reduce(void * a, void * b, int * len, const Op & op)
+{
+  const int size = *len;
+
+  T * in = static_cast<T *>(a);
+  T * inout = static_cast<T *>(b);
+  for (int i=0; i != size; ++i)
+    for_each_struct_field<T>
+      ([&in, &inout, &op, i](auto member)
+       {
+         typedef StructMemberEntries
+           <typename StructMember<decltype(member)>::type> entries;
+         const auto * in_entry = entries::first(in[i].*member);
+         auto * inout_entry = entries::first(inout[i].*member);
+         for (std::size_t j=0; j != entries::count(); ++j)
+           inout_entry[j] = op(in_entry[j], inout_entry[j]);
+       });
+}
+
+} // namespace detail
+
+
+
+/**
+ * The StandardType implementation for TIMPI_STANDARD_TYPE_STRUCT:
+ * an MPI struct datatype with one block per listed member, resized
+ * to account for padding.  Like the std::pair and std::tuple
+ * datatypes, it is built and committed once, then kept until TIMPI
+ * exits.
+ */
+template <typename T>
+class StructStandardType : public DataType
+{
+public:
+  explicit
+  StructStandardType(const T * example = nullptr);
+
+  StructStandardType(const StructStandardType<T> & t)
+    : DataType()
+  {
+    _datatype = t._datatype;
+  }
+
+  StructStandardType & operator=(const StructStandardType & t)
+  {
+    _datatype = t._datatype;
+    return *this;
+  }
+
+  static const bool is_fixed_type =
+    detail::StructFieldsFixed<decltype(StructFields<T>::fields())>::value;
+};
+
+
+
+template <typename T>
+inline
+StructStandardType<T>::StructStandardType(const T * example)
+  : DataType()
+{
+  static_assert(is_fixed_type,
+                "TIMPI_STANDARD_TYPE_STRUCT members must have fixed StandardTypes");
+
+#ifdef TIMPI_HAVE_MPI
+  static data_type static_type = MPI_DATATYPE_NULL;
+  if (static_type == MPI_DATATYPE_NULL)
+    {
+      // We need an example for MPI_Address to use
+      static const T t{};
+      if (!example)
+        example = &t;
+      T * ex = const_cast<T *>(example);
+
+      MPI_Aint start;
+      timpi_call_mpi
+        (MPI_Get_address (ex, &start));
+
+      // Get the sub-data-types, and make sure they live long enough
+      // to construct the derived type
+      std::vector<std::unique_ptr<DataType>> subtypes;
+      std::vector<MPI_Datatype> types;
+      std::vector<int> blocklengths;
+      std::vector<MPI_Aint> displs;
+
+      detail::for_each_struct_field<T>
+        ([ex, start, &subtypes, &types, &blocklengths, &displs]
+         (auto member)
+         {
+           typedef detail::StructMemberEntries
+             <typename detail::StructMember<decltype(member)>::type> entries;
+           typedef typename entries::element_type element_type;
+
+           element_type * first = entries::first(ex->*member);
+           subtypes.emplace_back
+             (std::make_unique<StandardType<element_type>>(first));
+           types.push_back((data_type)(*subtypes.back()));
+           blocklengths.push_back(int(entries::count()));
+
+           MPI_Aint displ;
+           timpi_call_mpi
+             (MPI_Get_address (first, &displ));
+           displs.push_back(displ - start);
+         });
+
+      // create a prototype structure
+      MPI_Datatype tmptype;
+      timpi_call_mpi
+        (MPI_Type_create_struct (int(types.size()), blocklengths.data(),
+                                 displs.data(), types.data(), &tmptype));
+      timpi_call_mpi
+        (MPI_Type_commit (&tmptype));
+
+      // resize the structure type to account for padding, if any
+      timpi_call_mpi
+        (MPI_Type_create_resized (tmptype, 0, sizeof(T), &static_type));
+      timpi_call_mpi
+        (MPI_Type_free (&tmptype));
+
+      SemiPermanent::add
+        (std::make_unique<ManageType>(static_type));
+    }
+  _datatype = static_type;
+#else
+  timpi_ignore(example);
+#endif // TIMPI_HAVE_MPI
+}
+
+
+
+/**
+ * The OpFunction implementation for TIMPI_STANDARD_TYPE_STRUCT:
+ * element-wise reductions over every listed member.  The MPI_Op for
+ * each reduction is created the first time it is used.
+ */
+#ifdef TIMPI_HAVE_MPI
+template <typename T>
+class StructOpFunction
+{
+  static void timpi_mpi_struct_max(void * a, void * b, int * len, MPI_Datatype *)
+  {
+    detail::struct_reduce<T>
+      (a, b, len, [](const auto & x, const auto & y) { return std::max(x, y); });
+  }
+
+  static void timpi_mpi_struct_min(void * a, void * b, int * len, MPI_Datatype *)
+  {
+    detail::struct_reduce<T>
+      (a, b, len, [](const auto & x, const auto & y) { return std::min(x, y); });
+  }
+
+  static void timpi_mpi_struct_plus(void * a, void * b, int * len, MPI_Datatype *)
+  {
+    detail::struct_reduce<T>
+      (a, b, len, [](const auto & x, const auto & y) { return x + y; });
+  }
+
+  static void timpi_mpi_struct_multiplies(void * a, void * b, int * len, MPI_Datatype *)
+  {
+    detail::struct_reduce<T>
+      (a, b, len, [](const auto & x, const auto & y) { return x * y; });
+  }
+
+public:
+  TIMPI_MPI_OPFUNCTION(max, struct_max)
+  TIMPI_MPI_OPFUNCTION(min, struct_min)
+  TIMPI_MPI_OPFUNCTION(sum, struct_plus)
+  TIMPI_MPI_OPFUNCTION(product, struct_multiplies)
+};
+#else
+template <typename T>
+class StructOpFunction {};
+#endif // TIMPI_HAVE_MPI
+
+} // namespace TIMPI
+
+#endif // TIMPI_STANDARD_TYPE_STRUCT_H
@@ -25,6 +25,8 @@
 #include "timpi/timpi_config.h"
 
 // C/C++ includes
+#include <cstddef>
+
 #ifdef TIMPI_HAVE_MPI
 #  include "timpi/ignore_warnings.h"
 #  include "mpi.h"
@@ -43,6 +45,11 @@ namespace TIMPI
  */
 typedef MPI_Status status;
 
+/**
+ * Handle for a message matched by a matched probe
+ */
+typedef MPI_Message message_handle;
+
 #  if MPI_VERSION > 3
 typedef MPI_Count CountType;
 #define TIMPI_GET_COUNT MPI_Get_count_c
@@ -108,10 +115,41 @@ public:
 
   CountType size () const;
 
+  /**
+   * Like size(), but also works for messages with more entries than a
+   * CountType can hold, which MPI 3 can only send with derived
+   * datatypes.
+   */
+  std::size_t large_size (const data_type & type) const;
+
+  std::size_t large_size () const;
+
+#ifdef TIMPI_HAVE_MPI
+  /**
+   * The message matched by the probe which filled this Status, if
+   * that was a matched probe (e.g. from
+   * Communicator::packed_range_matched_probe()), or MPI_MESSAGE_NULL
+   * otherwise.  A matched message has been removed from the message
+   * queue, so it can only be received via this handle, and only
+   * once; receiving it resets the handle to MPI_MESSAGE_NULL.
+   */
+  message_handle * matched_message() { return &_message; }
+
+  /**
+   * Whether this Status holds a matched message still waiting to be
+   * received.
+   */
+  bool has_matched_message() const { return _message != MPI_MESSAGE_NULL; }
+#endif
+
 private:
 
   status    _status;
   data_type _datatype;
+
+#ifdef TIMPI_HAVE_MPI
+  message_handle _message = MPI_MESSAGE_NULL;
+#endif
 };
 
 // ------------------------------------------------------------
@@ -137,6 +175,9 @@ inline Status::Status (const Status    & stat,
                        const data_type & type) :
   _status(stat._status),
   _datatype(type)
+#ifdef TIMPI_HAVE_MPI
+  , _message(stat._message)
+#endif
 {}
 
 inline int Status::source () const
@@ -173,6 +214,47 @@ inline CountType Status::size (const data_type & type) const
 inline CountType Status::size () const
 { return this->size (this->datatype()); }
 
+inline std::size_t Status::large_size (const data_type & type) const
+{
+#if defined(TIMPI_HAVE_MPI) && MPI_VERSION < 4
+  int msg_size = MPI_UNDEFINED;
+  timpi_call_mpi
+    (MPI_Get_count(const_cast<MPI_Status*>(&_status), type, &msg_size));
+
+  if (msg_size != MPI_UNDEFINED)
+    return std::size_t(msg_size);
+
+  // Too many entries for an int; count the basic elements of type
+  // instead, and divide by the number of those in each entry
+  MPI_Count n_elements = 0, entry_elements = 0;
+  timpi_call_mpi
+    (MPI_Get_elements_x(const_cast<MPI_Status*>(&_status), type,
+                        &n_elements));
+
+  // MPI 3 has no direct query for that, but a status holding fewer
+  // elements than one entry doesn't have a count yet
+  MPI_Status partial = _status;
+  int n_entries = MPI_UNDEFINED;
+  while (n_entries == MPI_UNDEFINED)
+    {
+      ++entry_elements;
+      timpi_call_mpi
+        (MPI_Status_set_elements_x(&partial, type, entry_elements));
+      timpi_call_mpi
+        (MPI_Get_count(&partial, type, &n_entries));
+    }
+
+  timpi_assert_equal_to (n_entries, 1);
+  timpi_assert_equal_to (n_elements % entry_elements, 0);
+  return std::size_t(n_elements / entry_elements);
+#else
+  return std::size_t(this->size(type));
+#endif
+}
+
+inline std::size_t Status::large_size () const
+{ return this->large_size (this->datatype()); }
+
 
 } // namespace TIMPI
 
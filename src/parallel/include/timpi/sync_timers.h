@@ -0,0 +1,277 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+
+#ifndef TIMPI_SYNC_TIMERS_H
+#define TIMPI_SYNC_TIMERS_H
+
+// C++ includes
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+
+namespace TIMPI
+{
+
+// Forward declarations
+class Communicator;
+
+//------------------------------------------------------------------------
+/**
+ * Splits the time spent in push_parallel_vector_data,
+ * push_parallel_packed_range, and pull_parallel_vector_data into
+ * phases, so that time spent waiting on other processors (load
+ * imbalance) can be told apart from time spent in the network and
+ * time spent in user code.
+ *
+ * Timing is opt-in: syncs are only timed while a Recording object
+ * for a SyncTimers is in scope on the calling thread, e.g.
+ *
+ * \verbatim
+ * SyncTimers timers;
+ * {
+ *   SyncTimers::Recording recording(timers);
+ *   push_parallel_vector_data(comm, data, act_on_data);
+ * }
+ * auto stats = timers.global_stats(comm);
+ * \endverbatim
+ *
+ * Phase times are exclusive: time spent in act_on_data() called
+ * from within a receive loop counts only as ACT_ON_DATA, for
+ * instance.  Packing for nonblocking packed range sends is charged
+ * to PACK whenever recording is active, not just inside syncs.
+ */
+class SyncTimers
+{
+public:
+  /**
+   * PACK: serializing variable-size data into send buffers.
+   * SEND_POST: posting sends.
+   * RECEIVE_WAIT: waiting for messages to arrive, or for sends to
+   * complete, before this processor has finished its own work.
+   * ACT_ON_DATA: in the user's action functor.
+   * BARRIER_WAIT: synchronizing with other processors, including
+   * waiting in the NBX barrier after this processor has finished.
+   */
+  enum Phase { PACK = 0,
+               SEND_POST,
+               RECEIVE_WAIT,
+               ACT_ON_DATA,
+               BARRIER_WAIT,
+               N_PHASES };
+
+  static const char * phase_name(Phase phase);
+
+  /**
+   * While in scope, times syncs on this thread into \p timers.
+   */
+  class Recording
+  {
+  public:
+    Recording(SyncTimers & timers);
+
+    ~Recording();
+
+    Recording(const Recording &) = delete;
+    Recording & operator=(const Recording &) = delete;
+
+  private:
+    SyncTimers * const _parent;
+  };
+
+  /**
+   * While in scope, charges time on this thread to \p phase in the
+   * active SyncTimers, if there is one.  Time spent in a nested
+   * PhaseTimer is charged to the nested phase instead.
+   */
+  class PhaseTimer
+  {
+  public:
+    PhaseTimer(Phase phase);
+
+    ~PhaseTimer();
+
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer & operator=(const PhaseTimer &) = delete;
+
+    /**
+     * Charge time from now on to \p phase instead.
+     */
+    void switch_to(Phase phase);
+
+  private:
+    typedef std::chrono::steady_clock clock_type;
+
+    // Charge time since _start to our phase, and restart
+    void charge(clock_type::time_point now);
+
+    SyncTimers * const _timers;
+    PhaseTimer * const _parent;
+    Phase _phase;
+    clock_type::time_point _start;
+  };
+
+  SyncTimers();
+
+  /**
+   * Count one sync in the active SyncTimers, if there is one.
+   */
+  static void count_sync();
+
+  /**
+   * The total seconds this processor has spent in \p phase.
+   */
+  double seconds(Phase phase) const { return _seconds[phase]; }
+
+  /**
+   * The number of syncs timed on this processor.  A pull counts as
+   * two: one for the queries and one for the responses.
+   */
+  std::size_t n_syncs() const { return _n_syncs; }
+
+  void clear();
+
+  struct Stats
+  {
+    double min, max, avg;
+  };
+
+  /**
+   * Returns the minimum, maximum, and average over processors of
+   * the seconds spent in each phase.  Collective.
+   */
+  std::array<Stats, N_PHASES> global_stats(const Communicator & comm) const;
+
+private:
+  static SyncTimers *& current_timers();
+  static PhaseTimer *& current_phase();
+
+  std::array<double, N_PHASES> _seconds;
+
+  std::size_t _n_syncs;
+};
+
+
+
+// ------------------------------------------------------------
+// SyncTimers member functions
+
+inline
+SyncTimers *&
+SyncTimers::current_timers()
+{
+  static thread_local SyncTimers * current = nullptr;
+  return current;
+}
+
+
+
+inline
+SyncTimers::PhaseTimer *&
+SyncTimers::current_phase()
+{
+  static thread_local PhaseTimer * current = nullptr;
+  return current;
+}
+
+
+
+inline
+void
+SyncTimers::count_sync()
+{
+  SyncTimers * timers = current_timers();
+  if (timers)
+    ++timers->_n_syncs;
+}
+
+
+
+inline
+SyncTimers::Recording::Recording(SyncTimers & timers) :
+  _parent(current_timers())
+{
+  current_timers() = &timers;
+}
+
+
+
+inline
+SyncTimers::Recording::~Recording()
+{
+  current_timers() = _parent;
+}
+
+
+
+inline
+SyncTimers::PhaseTimer::PhaseTimer(Phase phase) :
+  _timers(current_timers()),
+  _parent(_timers ? current_phase() : nullptr),
+  _phase(phase)
+{
+  if (!_timers)
+    return;
+
+  _start = clock_type::now();
+  if (_parent)
+    _parent->charge(_start);
+  current_phase() = this;
+}
+
+
+
+inline
+SyncTimers::PhaseTimer::~PhaseTimer()
+{
+  if (!_timers)
+    return;
+
+  const clock_type::time_point now = clock_type::now();
+  this->charge(now);
+  if (_parent)
+    _parent->_start = now;
+  current_phase() = _parent;
+}
+
+
+
+inline
+void
+SyncTimers::PhaseTimer::switch_to(Phase phase)
+{
+  if (_timers)
+    this->charge(clock_type::now());
+  _phase = phase;
+}
+
+
+
+inline
+void
+SyncTimers::PhaseTimer::charge(clock_type::time_point now)
+{
+  _timers->_seconds[_phase] +=
+    std::chrono::duration<double>(now - _start).count();
+  _start = now;
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_SYNC_TIMERS_H
@@ -0,0 +1,130 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_TERMINATION_DETECTOR_H
+#define TIMPI_TERMINATION_DETECTOR_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/request.h"
+
+// C++ includes
+#include <cstddef>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * Detects global termination of an asynchronous algorithm, in which
+ * processors exchange messages whose handling may send further
+ * messages, so that no processor can know locally when it's done.
+ *
+ * The user counts each message sent with sent() and each message
+ * received and fully processed with received(), then calls poll()
+ * from their progress loop whenever they are locally idle, i.e.
+ * have no work left that isn't waiting on a message to arrive.
+ * poll() returns true, on every processor, once every message sent
+ * anywhere has been received and no processor can send more.
+ *
+ * This uses the "four counter" method: global counts of messages
+ * sent and received are collected with nonblocking reductions
+ * ("waves"), so progress can continue while a wave is underway, and
+ * termination is declared once two consecutive waves report equal
+ * and unchanged counts.
+ *
+ * Each wave is a collective operation on the Communicator, so no
+ * other collective may be started on that Communicator while
+ * poll() is still returning false.
+ */
+class TerminationDetector
+{
+public:
+  TerminationDetector(const Communicator & comm);
+
+  ~TerminationDetector();
+
+  TerminationDetector(const TerminationDetector &) = delete;
+  TerminationDetector & operator=(const TerminationDetector &) = delete;
+
+  /**
+   * Count \p n messages sent from this processor.
+   */
+  void sent(std::size_t n = 1) { _n_sent += n; }
+
+  /**
+   * Count \p n messages received and processed on this processor.
+   */
+  void received(std::size_t n = 1) { _n_received += n; }
+
+  /**
+   * Advance termination detection.  Starts a new wave if none is
+   * underway, so this should only be called when locally idle;
+   * otherwise just tests the current wave.
+   *
+   * Returns true once global termination has been detected.  Must
+   * be called on every processor until it returns true.
+   */
+  bool poll();
+
+  /**
+   * Returns true if global termination has been detected.
+   */
+  bool terminated() const { return _terminated; }
+
+  /**
+   * Prepares to detect termination of a new phase of the
+   * algorithm.  Counts are kept, since they are still consistent
+   * from one phase to the next.
+   */
+  void reset();
+
+  /**
+   * The total numbers of messages counted on this processor.
+   */
+  std::size_t n_sent() const { return _n_sent; }
+  std::size_t n_received() const { return _n_received; }
+
+  /**
+   * The number of waves completed so far.
+   */
+  std::size_t n_waves() const { return _n_waves; }
+
+private:
+  const Communicator & _comm;
+
+  std::size_t _n_sent, _n_received;
+
+  // Local contributions to and global results of the current wave
+  std::size_t _wave_sent, _wave_received;
+  std::size_t _global_sent, _global_received;
+  Request _sent_request, _received_request;
+  bool _wave_underway;
+
+  // Results of the previous wave
+  bool _have_previous;
+  std::size_t _previous_sent, _previous_received;
+
+  std::size_t _n_waves;
+
+  bool _terminated;
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_TERMINATION_DETECTOR_H
@@ -0,0 +1,108 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_VECTOR_SUBSET_H
+#define TIMPI_VECTOR_SUBSET_H
+
+// TIMPI includes
+#include "timpi/data_type.h"
+
+// C++ includes
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace TIMPI
+{
+
+//-------------------------------------------------------------------
+/**
+ * Selects some of the entries of a std::vector, either by an explicit
+ * list of indices or by a start, count and stride, so that
+ * Communicator can send, receive or broadcast just those entries
+ * directly from or into the vector, with no packed copy.
+ *
+ * The selected entries are communicated in selection order, so a
+ * subset send matches a subset receive of the same size, or a plain
+ * receive of that many entries, and vice versa.
+ *
+ * Derived datatypes describing each selection pattern are cached, so
+ * repeatedly communicating the same pattern builds its type only
+ * once.
+ */
+class VectorSubset
+{
+public:
+  /**
+   * Selects the entries at \p indices, in that order.  \p indices
+   * is not copied, and must outlive this object.
+   */
+  VectorSubset (const std::vector<std::size_t> & indices);
+
+  /**
+   * Selects \p count entries, starting at \p start, \p stride
+   * entries apart.
+   */
+  VectorSubset (std::size_t start,
+                std::size_t count,
+                std::size_t stride = 1);
+
+  /**
+   * The number of selected entries.
+   */
+  std::size_t size () const;
+
+  /**
+   * The index of the \p i th selected entry.
+   */
+  std::size_t operator[] (std::size_t i) const
+  { return _indices ? (*_indices)[i] : _start + i * _stride; }
+
+  /**
+   * The minimum size of a vector containing every selected entry.
+   */
+  std::size_t required_size () const { return _required_size; }
+
+  /**
+   * The index of the entry at which datatype() starts.
+   */
+  std::size_t offset () const { return _indices ? 0 : _start; }
+
+  /**
+   * \returns a committed datatype describing the selected entries of
+   * an array of \p base, starting from its offset() entry.
+   *
+   * Types are cached by pattern, and by \p base as long as it
+   * exists; the returned pointer keeps its type valid whether or not
+   * the cache later drops it.
+   */
+  std::shared_ptr<const DataType> datatype (const data_type & base) const;
+
+private:
+  const std::vector<std::size_t> * _indices;
+
+  std::size_t _start, _count, _stride;
+
+  std::size_t _required_size;
+
+  std::size_t _hash;
+};
+
+} // namespace TIMPI
+
+#endif // TIMPI_VECTOR_SUBSET_H
@@ -0,0 +1,407 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_WINDOW_H
+#define TIMPI_WINDOW_H
+
+// TIMPI includes
+#include "timpi/communicator.h"
+#include "timpi/data_type.h"
+#include "timpi/indexed_type.h"
+#include "timpi/standard_type.h"
+#include "timpi/timpi_assert.h"
+#include "timpi/timpi_call_mpi.h"
+#include "timpi/timpi_config.h"
+
+// C++ includes
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace TIMPI
+{
+
+#ifdef TIMPI_HAVE_MPI
+//-------------------------------------------------------------------
+/**
+ * Window object for one-sided communication
+ */
+typedef MPI_Win win;
+#else
+// Must be a unique type for function overloading to work properly.
+struct win { };
+#endif // TIMPI_HAVE_MPI
+
+
+/**
+ * The reductions a one-sided accumulate can apply; MPI only allows
+ * predefined operations there.  REPLACE is an atomic put.
+ */
+enum class AccumulateOp { SUM, PRODUCT, MIN, MAX, REPLACE };
+
+
+//-------------------------------------------------------------------
+/**
+ * Exposes a local array of \p T on every processor of a Communicator
+ * to one-sided (RMA) access by every other processor.
+ *
+ * Remote entries are read or written by index within a
+ * passive-target access epoch: lock_all(), any number of get(),
+ * put() and accumulate() calls, then unlock_all() or flush_all(),
+ * after which they are complete.  The owning processors take no part
+ * in any of this.
+ *
+ * Construction and destruction are collective.  The exposed array
+ * must outlive the Window, and must not be resized while it exists.
+ * \p T must have a fixed StandardType.
+ */
+template <typename T>
+class Window
+{
+public:
+  Window (const Communicator & comm,
+          T * data,
+          std::size_t size);
+
+  ~Window ();
+
+  Window (const Window &) = delete;
+  Window & operator= (const Window &) = delete;
+
+  /**
+   * Starts an access epoch on every processor's array.
+   */
+  void lock_all ();
+
+  /**
+   * Ends the access epoch, completing every pending operation.
+   */
+  void unlock_all ();
+
+  /**
+   * Completes every pending operation, at the origin and at the
+   * target, without ending the access epoch.
+   */
+  void flush_all ();
+
+  /**
+   * Makes remote writes to our own array visible to local reads, and
+   * vice versa, in combination with process synchronization.
+   */
+  void sync ();
+
+  /**
+   * Starts fetching entries \p indices of the array on processor \p
+   * target into \p out, which must have room for indices.size()
+   * entries, or into out[(*positions)[i]] for each i if \p positions
+   * is given.  The data is only valid once the get() is completed.
+   */
+  template <typename Index>
+  void get (processor_id_type target,
+            const std::vector<Index> & indices,
+            T * out,
+            const std::vector<std::size_t> * positions = nullptr) const;
+
+  /**
+   * Starts writing \p in, or in[(*positions)[i]] for each i, to
+   * entries \p indices of the array on processor \p target.  \p in
+   * must not change until the put() is completed.
+   */
+  template <typename Index>
+  void put (processor_id_type target,
+            const std::vector<Index> & indices,
+            const T * in,
+            const std::vector<std::size_t> * positions = nullptr);
+
+  /**
+   * As put(), but combining \p in with the existing entries via \p
+   * op, atomically with respect to other accumulates.  Only
+   * supported for built-in types.
+   */
+  template <typename Index>
+  void accumulate (processor_id_type target,
+                   const std::vector<Index> & indices,
+                   const T * in,
+                   AccumulateOp op,
+                   const std::vector<std::size_t> * positions = nullptr);
+
+  /**
+   * The local array we expose.
+   */
+  T * data () const { return _data; }
+
+  std::size_t size () const { return _size; }
+
+  const Communicator & comm () const { return _communicator; }
+
+  win & get () { return _win; }
+
+  const win & get () const { return _win; }
+
+private:
+  // Calls \p rma_call(origin_count, origin_type, target_type) with
+  // datatypes describing the entries \p indices on processor \p
+  // target and our buffer \p buf
+  template <typename Index, typename RmaCall>
+  void rma (processor_id_type target,
+            const std::vector<Index> & indices,
+            const T * buf,
+            const std::vector<std::size_t> * positions,
+            RmaCall rma_call) const;
+
+  const Communicator & _communicator;
+
+  T * _data;
+
+  std::size_t _size;
+
+  win _win;
+
+#ifndef NDEBUG
+  // Every processor's array size, for bounds checking
+  std::vector<std::size_t> _sizes;
+#endif
+};
+
+
+
+// ------------------------------------------------------------
+// Window inline member functions
+template <typename T>
+inline
+Window<T>::Window (const Communicator & comm,
+                   T * data,
+                   std::size_t size) :
+  _communicator(comm),
+  _data(data),
+  _size(size)
+{
+  static_assert(StandardType<T>::is_fixed_type,
+                "Only fixed-type data can be exposed in a Window");
+
+  timpi_assert(data || !size);
+
+#ifndef NDEBUG
+  comm.allgather(size, _sizes);
+#endif
+
+  timpi_call_mpi
+    (MPI_Win_create(data, MPI_Aint(size * sizeof(T)), int(sizeof(T)),
+                    MPI_INFO_NULL, comm.get(), &_win));
+}
+
+
+
+template <typename T>
+inline
+Window<T>::~Window ()
+{
+#ifdef TIMPI_HAVE_MPI
+  // Not bothering with return type; we can't throw in a destructor
+  MPI_Win_free(&_win);
+#endif
+}
+
+
+
+template <typename T>
+inline
+void Window<T>::lock_all ()
+{
+  timpi_call_mpi(MPI_Win_lock_all(0, _win));
+}
+
+
+
+template <typename T>
+inline
+void Window<T>::unlock_all ()
+{
+  timpi_call_mpi(MPI_Win_unlock_all(_win));
+}
+
+
+
+template <typename T>
+inline
+void Window<T>::flush_all ()
+{
+  timpi_call_mpi(MPI_Win_flush_all(_win));
+}
+
+
+
+template <typename T>
+inline
+void Window<T>::sync ()
+{
+  timpi_call_mpi(MPI_Win_sync(_win));
+}
+
+
+
+template <typename T>
+template <typename Index, typename RmaCall>
+inline
+void Window<T>::rma (processor_id_type target,
+                     const std::vector<Index> & indices,
+                     const T * buf,
+                     const std::vector<std::size_t> * positions,
+                     RmaCall rma_call) const
+{
+  timpi_ignore(target); // Only used for bounds checking
+  timpi_assert_less(target, _communicator.size());
+  timpi_assert(!positions || positions->size() == indices.size());
+
+  if (indices.empty())
+    return;
+
+#ifdef TIMPI_HAVE_MPI
+#ifndef NDEBUG
+  for (const Index & i : indices)
+    timpi_assert_less(std::size_t(i), _sizes[target]);
+#endif
+
+  // One operation per target, with the scattered entries described
+  // by derived types rather than copied
+  StandardType<T> type(buf);
+  IndexedType target_type(type, indices);
+
+  if (positions)
+    {
+      IndexedType origin_type(type, *positions);
+      rma_call(1, origin_type, target_type);
+    }
+  else
+    rma_call(cast_int<int>(indices.size()), type, target_type);
+#else
+  ignore(buf, rma_call);
+#endif
+}
+
+
+
+template <typename T>
+template <typename Index>
+inline
+void Window<T>::get (processor_id_type target,
+                     const std::vector<Index> & indices,
+                     T * out,
+                     const std::vector<std::size_t> * positions) const
+{
+#ifdef TIMPI_HAVE_MPI
+  this->rma(target, indices, out, positions,
+            [this, out, target]
+            (int origin_count, const data_type & origin_type,
+             const data_type & target_type)
+            {
+              timpi_call_mpi
+                (MPI_Get(out, origin_count, origin_type, int(target), 0,
+                         1, target_type, _win));
+            });
+#else
+  ignore(target);
+  for (std::size_t i = 0, n = indices.size(); i != n; ++i)
+    out[positions ? (*positions)[i] : i] = _data[indices[i]];
+#endif
+}
+
+
+
+template <typename T>
+template <typename Index>
+inline
+void Window<T>::put (processor_id_type target,
+                     const std::vector<Index> & indices,
+                     const T * in,
+                     const std::vector<std::size_t> * positions)
+{
+#ifdef TIMPI_HAVE_MPI
+  this->rma(target, indices, in, positions,
+            [this, in, target]
+            (int origin_count, const data_type & origin_type,
+             const data_type & target_type)
+            {
+              timpi_call_mpi
+                (MPI_Put(const_cast<T *>(in), origin_count, origin_type,
+                         int(target), 0, 1, target_type, _win));
+            });
+#else
+  ignore(target);
+  for (std::size_t i = 0, n = indices.size(); i != n; ++i)
+    _data[indices[i]] = in[positions ? (*positions)[i] : i];
+#endif
+}
+
+
+
+template <typename T>
+template <typename Index>
+inline
+void Window<T>::accumulate (processor_id_type target,
+                            const std::vector<Index> & indices,
+                            const T * in,
+                            AccumulateOp op,
+                            const std::vector<std::size_t> * positions)
+{
+#ifdef TIMPI_HAVE_MPI
+  MPI_Op mpi_op = MPI_REPLACE;
+  switch (op)
+    {
+    case AccumulateOp::SUM:     mpi_op = MPI_SUM;  break;
+    case AccumulateOp::PRODUCT: mpi_op = MPI_PROD; break;
+    case AccumulateOp::MIN:     mpi_op = MPI_MIN;  break;
+    case AccumulateOp::MAX:     mpi_op = MPI_MAX;  break;
+    case AccumulateOp::REPLACE: mpi_op = MPI_REPLACE; break;
+    default:
+      timpi_error_msg("Invalid AccumulateOp " << int(op));
+    }
+
+  this->rma(target, indices, in, positions,
+            [this, in, target, mpi_op]
+            (int origin_count, const data_type & origin_type,
+             const data_type & target_type)
+            {
+              timpi_call_mpi
+                (MPI_Accumulate(const_cast<T *>(in), origin_count,
+                                origin_type, int(target), 0, 1,
+                                target_type, mpi_op, _win));
+            });
+#else
+  ignore(target);
+  for (std::size_t i = 0, n = indices.size(); i != n; ++i)
+    {
+      T & entry = _data[indices[i]];
+      const T & value = in[positions ? (*positions)[i] : i];
+      switch (op)
+        {
+        case AccumulateOp::SUM:     entry += value; break;
+        case AccumulateOp::PRODUCT: entry *= value; break;
+        case AccumulateOp::MIN:     entry = std::min(entry, value); break;
+        case AccumulateOp::MAX:     entry = std::max(entry, value); break;
+        case AccumulateOp::REPLACE: entry = value; break;
+        default:
+          timpi_error_msg("Invalid AccumulateOp " << int(op));
+        }
+    }
+#endif
+}
+
+} // namespace TIMPI
+
+#endif // TIMPI_WINDOW_H
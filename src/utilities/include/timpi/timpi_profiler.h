@@ -0,0 +1,245 @@
+// The TIMPI Message-Passing Parallelism Library.
+// Copyright (C) 2002-2025 Benjamin S. Kirk, John W. Peterson, Roy H. Stogner
+
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+
+
+#ifndef TIMPI_PROFILER_H
+#define TIMPI_PROFILER_H
+
+// Local includes
+#include "timpi/timpi_config.h"
+
+// C/C++ includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace TIMPI
+{
+
+/**
+ * Statistics for a single TIMPI_LOG_SCOPE call site.  Each site is a
+ * function-local static, constructed on first use, which adds itself
+ * to a global list for Profiler to report on.
+ */
+class ProfileSite
+{
+public:
+  ProfileSite(const char * name, const char * category,
+              const char * file, int line);
+
+  ProfileSite(const ProfileSite &) = delete;
+  ProfileSite & operator=(const ProfileSite &) = delete;
+
+  /**
+   * Message sizes are histogrammed in powers of two: bin 0 counts
+   * empty messages, bin i counts messages of [2^(i-1), 2^i) bytes,
+   * and the last bin counts anything larger.
+   */
+  static const unsigned int n_size_bins = 32;
+
+  static unsigned int size_bin(std::size_t n_bytes);
+
+  const char * const name;
+  const char * const category;
+  const char * const file;
+  const int line;
+
+  std::atomic<std::uint64_t> count;
+  std::atomic<std::uint64_t> nanoseconds;
+  std::atomic<std::uint64_t> bytes;
+  std::array<std::atomic<std::uint64_t>, n_size_bins> size_histogram;
+
+  /**
+   * The next site in the global list, or nullptr.
+   */
+  const ProfileSite * next;
+};
+
+
+
+/**
+ * Times a single visit to a ProfileSite, if profiling is enabled
+ * when the visit begins.
+ */
+class ProfileScope
+{
+public:
+  ProfileScope(ProfileSite & site);
+
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope &) = delete;
+  ProfileScope & operator=(const ProfileScope &) = delete;
+
+private:
+  friend class Profiler;
+
+  ProfileSite * _site;
+
+  // The enclosing active scope on this thread, if any
+  ProfileScope * _parent;
+
+  std::chrono::steady_clock::time_point _start;
+
+  std::uint64_t _bytes;
+};
+
+
+
+/**
+ * The \p Profiler "class" is a namespace for controlling and
+ * reporting on the communication profile collected by
+ * TIMPI_LOG_SCOPE annotations, when TIMPI is configured with
+ * --enable-profiling.
+ *
+ * Profiling is off by default at runtime.  It can be turned on with
+ * enable(), or by setting the TIMPI_PROFILE environment variable
+ * before TIMPIInit is constructed: "summary" (or "1") writes a
+ * summary table to timpi_profile.<rank>.txt, and "trace" also writes
+ * a Chrome trace (viewable in chrome://tracing or Perfetto) to
+ * timpi_trace.<rank>.json, when TIMPIInit is destroyed.
+ */
+class Profiler
+{
+public:
+  /**
+   * Turn recording on or off.  Scopes already underway are
+   * unaffected.
+   */
+  static void enable(bool on = true);
+
+  static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+  /**
+   * Turn recording of individual events for a Chrome trace on or
+   * off.  This keeps every event in memory, so it is off by default
+   * even when profiling is enabled.
+   */
+  static void trace(bool on = true);
+
+  static bool tracing() { return _tracing.load(std::memory_order_relaxed); }
+
+  /**
+   * Attribute \p n_bytes of message data to the innermost active
+   * scope on this thread, if any.
+   */
+  static void add_bytes(std::size_t n_bytes);
+
+  /**
+   * Zero all statistics and discard any trace events.
+   */
+  static void clear();
+
+  /**
+   * Returns the head of the list of every call site visited so far.
+   */
+  static const ProfileSite * sites();
+
+  /**
+   * Print a table of counts, times, and bytes per call site, with
+   * message size histograms, sorted by total time.  Instantiations
+   * of the same templated call site are combined.
+   */
+  static void print_summary(std::ostream & os);
+
+  /**
+   * Print recorded events in Chrome trace JSON format, with \p pid
+   * (typically the rank) as the process id.
+   */
+  static void print_chrome_trace(std::ostream & os, unsigned int pid);
+
+  /**
+   * Choose what write_output() writes.
+   */
+  static void set_output(bool summary, bool chrome_trace);
+
+  /**
+   * Enable profiling and set outputs according to the TIMPI_PROFILE
+   * environment variable, if it is set.
+   */
+  static void read_environment();
+
+  /**
+   * Write any requested output files for processor \p rank.  Called
+   * by the TIMPIInit destructor.
+   */
+  static void write_output(unsigned int rank);
+
+private:
+  friend class ProfileSite;
+  friend class ProfileScope;
+
+  static void start(ProfileScope & scope);
+  static void stop(ProfileScope & scope);
+
+  static std::atomic<bool> _enabled;
+  static std::atomic<bool> _tracing;
+};
+
+
+
+// ------------------------------------------------------------
+// ProfileScope inline member functions
+inline
+ProfileScope::ProfileScope(ProfileSite & site) :
+  _site(Profiler::enabled() ? &site : nullptr),
+  _parent(nullptr),
+  _bytes(0)
+{
+  if (_site)
+    Profiler::start(*this);
+}
+
+
+
+inline
+ProfileScope::~ProfileScope()
+{
+  if (_site)
+    Profiler::stop(*this);
+}
+
+} // namespace TIMPI
+
+
+#ifdef TIMPI_ENABLE_PROFILING
+
+#define TIMPI_PROFILE_CONCAT_INNER(a,b) a ## b
+#define TIMPI_PROFILE_CONCAT(a,b) TIMPI_PROFILE_CONCAT_INNER(a,b)
+
+// Time the enclosing scope under the name f and category c
+#define TIMPI_LOG_SCOPE(f,c)                                            \
+  static TIMPI::ProfileSite TIMPI_PROFILE_CONCAT(timpi_profile_site_, __LINE__) \
+    (f, c, __FILE__, __LINE__);                                         \
+  const TIMPI::ProfileScope TIMPI_PROFILE_CONCAT(timpi_profile_scope_, __LINE__) \
+    (TIMPI_PROFILE_CONCAT(timpi_profile_site_, __LINE__))
+
+// Count a message of n bytes against the innermost logged scope
+#define TIMPI_LOG_BYTES(n) TIMPI::Profiler::add_bytes(n)
+
+#else
+
+// Unless TIMPI is configured with --enable-profiling, these are no-ops
+#define TIMPI_LOG_SCOPE(f,c)
+#define TIMPI_LOG_BYTES(n)
+
+#endif // TIMPI_ENABLE_PROFILING
+
+#endif // TIMPI_PROFILER_H